@@ -5,41 +5,399 @@
 * difficulty level, then a random word based on that difficulty level
 * is chosen from a text file. The hangman sprites to show the number
 * of guesses remaining are also loaded in by being read from a text
-* file.
+* file, once when the game starts.
 * 
 * File I/O is primarily being used in this program. The word bank of
-* words to choose from is stored in a file called allWords.txt while
+* words to choose from is stored in a file called allWords.txt (indexed
+* by a sidecar file, allWords.idx, that's rebuilt whenever the word bank
+* changes so a word can be read without scanning the file) while
 * an array of text file names ("attempt1.txt", "attempt2.txt", and so
-* on) is used to load in the hangman art. Arrays are also used to store
-* used letters, correct letters, and the current guess of the player,
-* so the game logic heavily relies on keeping track of which letters
-* have already been correctly played to allow the player to progress.
+* on) is used to load in the hangman art. The letters of the answer and
+* the letters guessed so far are each kept as a bitmask with one bit per
+* letter of the alphabet, so the game logic heavily relies on keeping
+* track of which letters have already been correctly played to allow
+* the player to progress.
+*
+* The game can also be hosted: --server plays many games at once over a
+* local socket, with --client standing in for the players. --tier sorts
+* a list of words into difficulty tiers and writes it out as the word
+* bank.
 */
 
 #define _CRT_SECURE_NO_WARNINGS
+#include <winsock2.h> // has to come before windows.h
+#include <afunix.h>
 #include <windows.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <string.h>
+#include <math.h>
 #include <time.h>
+#ifdef _M_X64
+#include <immintrin.h>
+#endif
+
+#pragma comment(lib, "Ws2_32.lib")
 
-#define NUM_WORDS 356
 #define NUM_ALPHABET 26
-#define MAX_WORD_LENGTH 1000
+#define NUM_TIERS 4 // one tier of words for each difficulty level
+#define NO_TIER 0xFF // a line that's never picked
+
+#define WORD_FILE "allWords.txt"
+#define WORD_INDEX_FILE "allWords.idx"
+#define WORD_INDEX_MAGIC 0x58444957 // "WIDX"
+
+#define NUM_SPRITES 8 // one hangman sprite for each number of wrong guesses
+#define MAX_WRONG_GUESSES 7 // the game is lost once the last sprite is drawn
+#define CLEAR_SCREEN "\x1b[2J\x1b[H" // clears the console and moves the cursor back to the top left
+#define FRAME_START_SIZE 4096
+
+// the narrow it down lifeline keeps a bitset for each letter at each position, and these two for everything else
+#define CANDIDATE_SPACE NUM_ALPHABET
+#define CANDIDATE_OTHER (NUM_ALPHABET + 1) // any other character that isn't a letter, like an apostrophe
+#define CANDIDATE_CLASSES (NUM_ALPHABET + 2)
+
+#define MAX_BENCH_THREADS 64 // for the benchmark and for tiering
+
+// how much each part of a word's difficulty score counts when tiering, next to the rarity of each letter in the word
+#define TIER_SOLVER_WEIGHT 4.0 // each wrong guess the solver needs
+#define TIER_TURN_WEIGHT 1.0 // each guess the solver needs, right or wrong
+#define TIER_LENGTH_WEIGHT 0.25 // each letter in the word
+#define COMMON_LETTERS "ETAOINSHRDLCUMWFGYPBVKJXQZ" // the solver's order for breaking ties between equally good letters
+
+#define SERVER_SOCKET_FILE "hangman.sock"
+#define SESSIONS_PER_SLAB 1024
+#define SESSION_BUFFER_SIZE 2048 // the longest command or reply line, including the word/phrase
+#define MAX_REPLY_EXTRA 64 // how much a reply adds to the word/phrase it shows
+
+// folds the next position a letter appears at into a key, so words with the letter in the same places get the same key
+#define NEXT_POSITION_KEY(key, position) (((key) ^ ((position) + 1)) * 0x100000001B3ull)
+
+// bit 0 is A, bit 1 is B, and so on up to bit 25 for Z
+typedef uint32_t LetterMask;
+
+/* the letters of the word/phrase and the letters the player has guessed. the correct and remaining letters are kept
+    up to date alongside them, so checking a guess, counting blanks and checking for a win never rescan the answer. */
+typedef struct {
+    LetterMask answerLetters; // every letter that appears in the answer
+    LetterMask guessedLetters; // every letter guessed so far, right or wrong
+    LetterMask correctLetters; // guessed letters that are in the answer
+    LetterMask remainingLetters; // answer letters that haven't been guessed yet
+} LetterState;
+
+/* the whole word bank read into memory at once, for the benchmark (getWord only ever reads the one word it picks).
+    the words are grouped by tier from easy to expert, the same as in the index. */
+typedef struct {
+    char* text; // every word, each followed by a '\0'
+    const char** words;
+    uint32_t* wordLengths;
+    uint32_t tierCounts[NUM_TIERS];
+    uint32_t wordCount;
+} WordBank;
+
+/* the words of one length, for the narrow it down lifeline. bit i of each bitset is the word at byLength[start + i]
+    in the candidate index, and each bitset is blockCount 64-bit blocks long. */
+typedef struct {
+    uint32_t start;
+    uint32_t count;
+    uint32_t blockCount;
+    uint64_t* atPosition; // [(position * CANDIDATE_CLASSES + letter) * blockCount + block], which words have the letter there
+    uint64_t* anywhere; // [letter * blockCount + block], which words have the letter at any position
+} CandidateLength;
+
+/* the whole word bank indexed by length, position and letter, so the words still matching a game are found by ANDing
+    a bitset for every position together instead of comparing every word. only built the first time a player uses
+    the narrow it down lifeline. */
+typedef struct {
+    WordBank bank;
+    uint32_t* byLength; // every word's number in the bank, sorted by length
+    CandidateLength* lengths; // indexed by length, from 0 up to maxLength
+    uint32_t maxLength;
+} CandidateIndex;
+
+/* everything about a game in progress. the game rules only ever change this through newGame, guessLetter,
+    guessPhrase and useLifeline, which don't read input or print anything, so a game can be played by a person
+    through displayGameState or by the solver in the benchmark. */
+typedef struct {
+    const char* word;
+    int difficultyLevel;
+    LetterState letters;
+    int numGuesses; // wrong guesses so far
+    int lifelinesRemaining;
+    int winCondition;
+    const CandidateIndex* candidates; // the word bank for the narrow it down lifeline, NULL if it isn't loaded
+    uint32_t matchingWords; // how many words the last narrow it down lifeline found
+} HangmanGame;
+
+/* words the player can't tell apart before guessing anything: the same length, with the same spaces and punctuation
+    in the same places. the solver's first guess only depends on the group, so it's worked out once per group, and the
+    group's words are sorted by where that letter appears so the words left after it are one contiguous run. */
+typedef struct {
+    uint32_t length;
+    uint64_t shapeKey;
+    uint32_t start; // the group is byShape[start] up to byShape[start + count]
+    uint32_t count;
+    char firstLetter; // '\0' if no guess could tell the group's words apart
+} ShapeGroup;
+
+typedef struct {
+    uint32_t length;
+    uint64_t shapeKey;
+    uint64_t firstKey;
+    uint32_t wordNumber;
+} SortedWord;
+
+typedef struct { // the word bank as the solver sees it, and the results so far, shared by all the worker threads
+    const WordBank* bank;
+    ShapeGroup* groups; // sorted by length then by shape key
+    uint32_t groupCount;
+    uint32_t* byShape; // every word's number in the bank, sorted by group then by firstKeys
+    uint64_t* firstKeys; // where each word in byShape has its group's first letter
+    uint32_t largestGroup; // the most candidates a game can start with
+    volatile LONG nextWord; // the last word claimed by a worker
+    volatile LONG wins[NUM_TIERS];
+    volatile LONG wrongGuesses[NUM_TIERS];
+    volatile LONG turns[NUM_TIERS];
+} BenchJob;
+
+typedef struct {
+    double score;
+    uint32_t wordNumber;
+    uint32_t letterCount;
+    int wrongGuesses; // how many the solver needed, without any lifelines
+} WordScore;
+
+typedef struct { // the words being tiered and their scores so far, shared by all the worker threads
+    BenchJob solver;
+    WordScore* scores;
+    double letterRarity[NUM_ALPHABET];
+    volatile LONG nextWord; // the last word claimed by a worker
+    volatile LONG scoredCount; // words the workers have scored, which falls short of the bank if any word was left unscored
+} TierJob;
+
+/* one connection to the server and the game it's playing. sessions are handed out from slabs of SESSIONS_PER_SLAB,
+    and closed sessions go on a free list to be reused, so the server only allocates memory as it reaches new peaks. */
+typedef struct Session {
+    SOCKET socket;
+    HangmanGame game;
+    int hasGame;
+    int isClosing; // close once the rest of the output is sent
+    char input[SESSION_BUFFER_SIZE]; // received text that doesn't make up a whole line yet
+    int inputLength;
+    char output[SESSION_BUFFER_SIZE]; // replies waiting to be sent
+    int outputLength;
+    int outputSent;
+    struct Session* nextFree;
+} Session;
+
+typedef struct {
+    Session** slabs;
+    int slabCount;
+    Session* freeList;
+} SessionPool;
+
+typedef struct {
+    WordBank bank; // shared by every session and never changed, so no game reads the word file
+    uint32_t tierStarts[NUM_TIERS];
+    int maxReplyLength; // the longest reply any word in the bank can get
+    SessionPool pool;
+    WSAPOLLFD* pollFds; // pollFds[0] is the listening socket, then one for each session
+    Session** sessions; // sessions[i] goes with pollFds[i]
+    int pollCount;
+    int pollCapacity;
+} HangmanServer;
+
+typedef struct { // one of the client's connections, playing its games one after another
+    SOCKET socket;
+    int gamesLeft;
+    int difficultyLevel;
+    const char* nextLetter;
+    int pipelinesQuit; // sends another command in the same write as its QUIT, which the server has to throw away
+    int isQuitting; // has sent that QUIT and is waiting for the server to close the connection
+    char input[SESSION_BUFFER_SIZE];
+    int inputLength;
+} ClientSession;
+
+typedef enum {
+    GUESS_CORRECT,
+    GUESS_WRONG,
+    GUESS_REPEATED,
+    GUESS_NOT_A_LETTER
+} GuessResult;
+
+typedef enum {
+    REVEAL_LETTER = 1,
+    EXTRA_GUESS = 2,
+    NARROW_DOWN = 3 // count the words in the word bank that still match
+} Lifeline;
+
+typedef enum {
+    LIFELINE_USED,
+    LIFELINE_NONE_LEFT,
+    LIFELINE_NOT_NEEDED, // an extra guess before any wrong guesses
+    LIFELINE_UNKNOWN,
+    LIFELINE_FAILED // the word bank couldn't be searched, so the lifeline wasn't spent
+} LifelineResult;
+
+/* the sidecar index starts with this header, followed by one WordEntry for every word in the word bank, grouped
+    by tier from easy to expert. it's only used while the word bank's size and last write time still match. */
+typedef struct {
+    uint32_t magic;
+    uint32_t tierCounts[NUM_TIERS];
+    uint32_t padding;
+    uint64_t wordFileSize;
+    uint64_t wordFileTime;
+} WordIndexHeader;
+
+typedef struct {
+    uint32_t offset; // where the word starts in the word bank
+    uint32_t length; // not counting the line ending
+} WordEntry;
+
+/* every sprite is stored back to back in one buffer, with the newline after it already included, so drawing the
+    hangman is a single write. sprite i runs from offsets[i] up to offsets[i + 1]. */
+typedef struct {
+    char* text;
+    size_t offsets[NUM_SPRITES + 1];
+} SpriteSheet;
+
+/* everything drawn on one turn, built up in memory and written out at once so the console only redraws once. the
+    text isn't null terminated. */
+typedef struct {
+    char* text;
+    size_t length;
+    size_t capacity;
+} Frame;
+
+typedef struct {
+    HANDLE file;
+    HANDLE mapping;
+    const void* view; // the mapped sidecar file, or a copy built in memory if the sidecar couldn't be written
+    int isMapped;
+    const WordIndexHeader* header;
+    const WordEntry* entries;
+} WordIndex;
 
 char* getWord(int difficultyLevel);
-void stringToUpper(char* str);
+int openWordIndex(WordIndex* index, const char* wordFile, const char* indexFile);
+int mapWordIndex(WordIndex* index, const char* indexFile, uint64_t wordFileSize, uint64_t wordFileTime);
+int buildWordIndex(WordIndex* index, const char* wordFile, const char* indexFile, uint64_t wordFileSize, uint64_t wordFileTime);
+int findWordTier(const char* line, int length);
+void closeWordIndex(WordIndex* index);
+uint32_t randomIndex(uint32_t count);
+int loadSprites(void);
+void freeSprites(void);
+void printHangman(Frame* frame, int numGuesses);
 void gameLoop(char* correctWord, int difficultyLevel, int* winCondition);
-void printDifficulty(int difficultyLevel);
-void printUsedLetters(char* usedLetters);
-void displayGameState(int* numGuesses, int difficultyLevel,
-    char* correctWord, char* usedLetters,
-    int* lifelinesRemaining, int* winCondition, char* correctLetters);
-int printBlanks(char* word, char* usedLetters);
+void printDifficulty(Frame* frame, int difficultyLevel);
+void printUsedLetters(Frame* frame, LetterMask usedLetters);
+void drawGame(Frame* frame, const HangmanGame* game, Frame* message);
+void displayGameState(HangmanGame* game, Frame* message);
+int printBlanks(Frame* frame, const char* word, LetterMask correctLetters);
+int enableVirtualTerminal(void);
+void startFrame(Frame* frame);
+int reserveFrame(Frame* frame, size_t extra);
+void addToFrame(Frame* frame, const char* format, ...);
+void addTextToFrame(Frame* frame, const char* text, size_t length);
+void showFrame(Frame* frame);
 int getNumLifelines(int difficultyLevel);
-int checkCurrentChar(char letter, char* word);
-int checkGuessLetter(char guess, char* correctStr, char* usedLetters);
+int endGame(int winCondition, int numGuesses);
+LetterMask letterBit(char letter);
+void startLetterState(LetterState* letters, const char* word);
+int checkGuessLetter(char guess, LetterState* letters);
+char findRevealLetter(const char* word, LetterMask remainingLetters);
+void newGame(HangmanGame* game, const char* word, int difficultyLevel);
+GuessResult guessLetter(HangmanGame* game, char letter);
+int guessPhrase(HangmanGame* game, const char* phrase);
+LifelineResult useLifeline(HangmanGame* game, Lifeline lifeline);
+int loadWordBank(WordBank* bank);
+void freeWordBank(WordBank* bank);
+int buildCandidateIndex(CandidateIndex* index);
+void freeCandidateIndex(CandidateIndex* index);
+uint32_t countCandidates(const CandidateIndex* index, const HangmanGame* game);
+int lowestSetBit(uint64_t bits);
+int countSetBits(uint64_t bits);
+int runBenchmark(int threadCount);
+VOID CALLBACK runBenchWorker(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work);
+void playBenchGames(BenchJob* job);
+int playSolverGame(const BenchJob* job, HangmanGame* game, uint32_t* candidates, uint64_t* keys);
+int matchesGame(const char* candidate, const HangmanGame* game);
+char chooseSolverLetter(LetterMask guessedLetters, const WordBank* bank, const uint32_t* candidates, uint32_t count,
+    uint64_t* keys, uint32_t keyStride);
+int compareKeys(const void* a, const void* b);
+int buildShapeGroups(BenchJob* job);
+void freeShapeGroups(BenchJob* job);
+const ShapeGroup* findShapeGroup(const BenchJob* job, const char* word);
+uint64_t findShapeKey(const char* word);
+uint64_t findLetterKey(const char* word, char letter);
+int compareSortedWords(const void* a, const void* b);
+int runWorkers(PTP_WORK_CALLBACK worker, void* context, int threadCount, uint32_t itemCount);
+int runTiering(const char* wordList, const char* wordFile, const char* indexFile, int threadCount);
+int loadWordList(WordBank* bank, const char* fileName);
+VOID CALLBACK runTierWorker(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work);
+void scoreWords(TierJob* job);
+int compareWordScores(const void* a, const void* b);
+int runServer(const char* socketFile);
+int addServerSocket(HangmanServer* server, SOCKET socket, Session* session);
+void removeServerSocket(HangmanServer* server, int index);
+void acceptSessions(HangmanServer* server);
+int readSession(Session* session);
+int writeSession(Session* session);
+void handleSessionInput(HangmanServer* server, Session* session);
+void handleSessionLine(HangmanServer* server, Session* session, char* line);
+void writeGameState(Session* session, const char* result);
+void writeSessionLine(Session* session, const char* line);
+Session* allocateSession(SessionPool* pool);
+void freeSession(SessionPool* pool, Session* session);
+void freeSessionPool(SessionPool* pool);
+int setNonBlocking(SOCKET socket);
+SOCKET openServerSocket(const char* socketFile, int isServer);
+int runClient(int sessionCount, int gamesPerSession, const char* socketFile);
+int sendClientLine(ClientSession* client, const char* line);
+
+SpriteSheet sprites; // loaded once at startup, and only read after that
+CandidateIndex candidateIndex; // built the first time it's needed
+Frame screen; // the frame being drawn, reused every turn
+int clearWithEscape; // whether the console understands CLEAR_SCREEN
+int turnDelay; // how long to pause after each turn, in milliseconds
+
+int main(int argc, char* argv[]) {
+
+    // bench mode plays the solver against every word in the word bank instead of playing a game
+    if (argc >= 2 && strcmp(argv[1], "--bench") == 0) {
+        return runBenchmark(argc >= 3 ? atoi(argv[2]) : 0) ? 0 : 1;
+    }
+
+    // tier mode scores every word in a list, splits them into the four difficulties and writes them out as the word bank
+    if (argc >= 3 && strcmp(argv[1], "--tier") == 0) {
+        return runTiering(argv[2], argc >= 4 ? argv[3] : WORD_FILE, argc >= 5 ? argv[4] : WORD_INDEX_FILE,
+            argc >= 6 ? atoi(argv[5]) : 0) ? 0 : 1;
+    }
+
+    // server mode hosts games for other programs over a local socket, and client mode plays games against it
+    if (argc >= 2 && strcmp(argv[1], "--server") == 0) {
+        return runServer(argc >= 3 ? argv[2] : SERVER_SOCKET_FILE) ? 0 : 1;
+    }
+    if (argc >= 2 && strcmp(argv[1], "--client") == 0) {
+        int sessionCount = argc >= 3 ? atoi(argv[2]) : 1;
+        int gamesPerSession = argc >= 4 ? atoi(argv[3]) : 1;
+        return runClient(sessionCount, gamesPerSession, argc >= 5 ? argv[4] : SERVER_SOCKET_FILE) ? 0 : 1;
+    }
+
+    // turns follow each other straight away unless a pause is asked for, like --delay 1000 for a second per turn
+    if (argc >= 3 && strcmp(argv[1], "--delay") == 0) {
+        turnDelay = atoi(argv[2]);
+    }
+    clearWithEscape = enableVirtualTerminal();
+
+    if (!loadSprites()) {
+        return 1;
+    }
+    atexit(freeSprites);
 
-int main(void) {
     int winCondition = 0;
     int difficultyInput = 0;
     char confirmDifficulty = ' ';
@@ -91,9 +449,11 @@ int main(void) {
             confirmDifficulty = ' ';
         }
     }
-    system("cls");
 
     char* gameWord = getWord(difficultyInput); // getting a random word from the word bank
+    if (gameWord == NULL) {
+        return 1;
+    }
     gameLoop(gameWord, difficultyInput, &winCondition); // enter the game loop to begin the game
 
     if (winCondition) {
@@ -104,94 +464,323 @@ int main(void) {
     }
 
     free(gameWord);
+    freeCandidateIndex(&candidateIndex);
+    free(screen.text);
     return 0;
 }
 
 char* getWord(int difficultyLevel) {
     srand(time(NULL));
-    int wordIndex;
 
-    // choose a random word depending the difficulty level
-        // the difficulty levels are separated by how far down they are in the text file.
-        // so for instance, lines 1-62 each contain a word under the easy category.
-        // then, lines 64-111 each contain a word for the medium category, and so on.
-    switch (difficultyLevel) {
-    case 1: // easy words
-        wordIndex = (rand() % 63) + 1;
-        break;
-    case 2: // medium words
-        wordIndex = (rand() % (111 - 64 + 1)) + 64;
-        break;
-    case 3: // hard words
-        wordIndex = (rand() % (326 - 112 + 1)) + 112;
-        break;
-    case 4: // expert words
-        wordIndex = (rand() % (356 - 327 + 1)) + 327;
-        break;
+    WordIndex index;
+    if (!openWordIndex(&index, WORD_FILE, WORD_INDEX_FILE)) {
+        return NULL;
     }
 
-    FILE* allWords = fopen("allWords.txt", "r");
-    if (allWords == NULL) {
-        fprintf(stderr, "An error occurred trying to open allWords.txt\n");
+    // choose a random word from the difficulty level's tier, which comes after the words of every easier tier
+    int tier = difficultyLevel - 1;
+    if (index.header->tierCounts[tier] == 0) {
+        fprintf(stderr, "There are no words for this difficulty in %s\n", WORD_FILE);
+        closeWordIndex(&index);
         return NULL;
     }
-    fseek(allWords, 0, SEEK_SET); // move the file pointer to the beginning of the file
 
-    // moving to the randomly chosen word's line number in the text file
-    int currentLine = 0;
-    while (currentLine < wordIndex) {
-        if (fgetc(allWords) == '\n') {
-            currentLine++;
-        }
+    uint32_t firstWord = 0;
+    for (int i = 0; i < tier; i++) {
+        firstWord += index.header->tierCounts[i];
     }
+    WordEntry chosen = index.entries[firstWord + randomIndex(index.header->tierCounts[tier])];
+    closeWordIndex(&index);
 
-    // using fscanf to copy the word from the text file to a char array variable
-    char chosenWord[MAX_WORD_LENGTH];
-    if (fscanf(allWords, "%[^\n]", chosenWord) != 1) {
-        fprintf(stderr, "Error reading word from file\n");
-        fclose(allWords);
+    FILE* allWords = fopen(WORD_FILE, "rb");
+    if (allWords == NULL) {
+        fprintf(stderr, "An error occurred trying to open allWords.txt\n");
         return NULL;
     }
-    chosenWord[sizeof(chosenWord) - 1] = '\0'; // null terminating the string
-
-    int wordSize = strlen(chosenWord);
 
     // allocating the appropriate amount of memory for the word
-    char* finalWord = malloc(sizeof(char) * (wordSize + 1));
+    char* finalWord = malloc(sizeof(char) * (chosen.length + 1));
     if (finalWord == NULL) {
         fprintf(stderr, "Memory allocation failed!\n");
         fclose(allWords);
         return NULL;
     }
-    strcpy(finalWord, chosenWord);
+
+    // reading the word straight from where the index says it starts
+    if (_fseeki64(allWords, chosen.offset, SEEK_SET) != 0 || fread(finalWord, 1, chosen.length, allWords) != chosen.length) {
+        fprintf(stderr, "Error reading word from file\n");
+        free(finalWord);
+        fclose(allWords);
+        return NULL;
+    }
+    finalWord[chosen.length] = '\0'; // null terminating the string
 
     fclose(allWords);
     return finalWord;
 }
 
-void printDifficulty(int difficultyLevel) {
+int openWordIndex(WordIndex* index, const char* wordFile, const char* indexFile) {
+    WIN32_FILE_ATTRIBUTE_DATA wordFileInfo;
+    if (!GetFileAttributesExA(wordFile, GetFileExInfoStandard, &wordFileInfo)) {
+        fprintf(stderr, "An error occurred trying to open %s\n", wordFile);
+        return 0;
+    }
+    uint64_t wordFileSize = (uint64_t)wordFileInfo.nFileSizeHigh << 32 | wordFileInfo.nFileSizeLow;
+    uint64_t wordFileTime = (uint64_t)wordFileInfo.ftLastWriteTime.dwHighDateTime << 32 | wordFileInfo.ftLastWriteTime.dwLowDateTime;
+
+    // the sidecar is mapped straight into memory, so opening it takes the same time no matter how many words there are
+    if (mapWordIndex(index, indexFile, wordFileSize, wordFileTime)) {
+        return 1;
+    }
+
+    // otherwise it's missing or out of date, so it's rebuilt from the word bank
+    return buildWordIndex(index, wordFile, indexFile, wordFileSize, wordFileTime);
+}
+
+int mapWordIndex(WordIndex* index, const char* indexFile, uint64_t wordFileSize, uint64_t wordFileTime) {
+    memset(index, 0, sizeof(WordIndex));
+    index->isMapped = 1;
+
+    index->file = CreateFileA(indexFile, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (index->file == INVALID_HANDLE_VALUE) {
+        index->file = NULL;
+        return 0;
+    }
+
+    LARGE_INTEGER indexSize;
+    if (!GetFileSizeEx(index->file, &indexSize) || indexSize.QuadPart < (long long)sizeof(WordIndexHeader)) {
+        closeWordIndex(index);
+        return 0;
+    }
+
+    index->mapping = CreateFileMappingA(index->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    index->view = index->mapping != NULL ? MapViewOfFile(index->mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (index->view == NULL) {
+        closeWordIndex(index);
+        return 0;
+    }
+    index->header = index->view;
+    index->entries = (const WordEntry*)(index->header + 1);
+
+    // only trust the index if it was built from the word bank as it is now, and it's long enough to hold every entry it counts
+    uint64_t wordCount = 0;
+    for (int i = 0; i < NUM_TIERS; i++) {
+        wordCount += index->header->tierCounts[i];
+    }
+    if (index->header->magic != WORD_INDEX_MAGIC || index->header->wordFileSize != wordFileSize || index->header->wordFileTime != wordFileTime ||
+        (uint64_t)indexSize.QuadPart < sizeof(WordIndexHeader) + wordCount * sizeof(WordEntry)) {
+        closeWordIndex(index);
+        return 0;
+    }
+    return 1;
+}
+
+/* each non-empty line of the word bank is a word. a line like [EASY] or [EXPERT] starts that difficulty's tier, and a
+    word bank without any of those lines is split by line number the way it always has been, counting from 0: line 0
+    is never picked, lines 1-63 are easy, 64-111 medium, 112-326 hard, and the rest expert. */
+int buildWordIndex(WordIndex* index, const char* wordFile, const char* indexFile, uint64_t wordFileSize, uint64_t wordFileTime) {
+    const uint32_t legacyTierStarts[NUM_TIERS] = { 1, 64, 112, 327 };
+
+    memset(index, 0, sizeof(WordIndex));
+    if (wordFileSize > UINT32_MAX) {
+        fprintf(stderr, "%s is too big to index\n", wordFile);
+        return 0;
+    }
+
+    FILE* allWords = fopen(wordFile, "rb");
+    if (allWords == NULL) {
+        fprintf(stderr, "An error occurred trying to open %s\n", wordFile);
+        return 0;
+    }
+
+    // the words are first collected in file order along with their tier, then grouped by tier
+    WordEntry* words = NULL;
+    unsigned char* wordTiers = NULL;
+    uint32_t wordCount = 0, wordCapacity = 0;
+    int hasTierLines = 0;
+    int currentTier = 0;
+    uint32_t lineNumber = 0;
+
+    char lineStart[16]; // enough of each line to tell whether it starts a tier
+    uint32_t lineOffset = 0, lineLength = 0;
+    char lastChar = '\0';
+    uint32_t offset = 0;
+    unsigned char buffer[65536];
+    size_t bytesRead;
+    int isFinished = 0;
+    int hasFailed = 0;
+
+    while (!isFinished && !hasFailed) {
+        bytesRead = fread(buffer, 1, sizeof(buffer), allWords);
+        isFinished = bytesRead < sizeof(buffer);
+
+        // a word bank that doesn't end with a newline still has a last word to finish
+        for (size_t i = 0; i <= bytesRead && !hasFailed; i++) {
+            if (i == bytesRead && !(isFinished && lineLength > 0)) {
+                break;
+            }
+
+            if (i < bytesRead && buffer[i] != '\n') {
+                if (lineLength < sizeof(lineStart)) {
+                    lineStart[lineLength] = buffer[i];
+                }
+                lastChar = buffer[i];
+                lineLength++;
+                continue;
+            }
+
+            // the end of a line: drop a carriage return, then record the word (or the tier it starts)
+            uint32_t length = lineLength;
+            if (length > 0 && lastChar == '\r') {
+                length--;
+            }
+
+            int tier = findWordTier(lineStart, length < sizeof(lineStart) ? length : sizeof(lineStart));
+            if (tier >= 0) {
+                // once the word bank has tier lines, any words before the first one are easy words
+                if (!hasTierLines && wordCount > 0) {
+                    memset(wordTiers, 0, wordCount);
+                }
+                hasTierLines = 1;
+                currentTier = tier;
+            }
+            else if (length > 0) {
+                if (wordCount == wordCapacity) {
+                    wordCapacity = wordCapacity == 0 ? 1024 : wordCapacity * 2;
+                    WordEntry* newWords = realloc(words, wordCapacity * sizeof(WordEntry));
+                    if (newWords != NULL) words = newWords;
+                    unsigned char* newTiers = realloc(wordTiers, wordCapacity);
+                    if (newTiers != NULL) wordTiers = newTiers;
+                    if (newWords == NULL || newTiers == NULL) {
+                        fprintf(stderr, "Memory allocation failed!\n");
+                        hasFailed = 1;
+                        break;
+                    }
+                }
+
+                int legacyTier = lineNumber < legacyTierStarts[0] ? NO_TIER : 0;
+                while (legacyTier != NO_TIER && legacyTier < NUM_TIERS - 1 && lineNumber >= legacyTierStarts[legacyTier + 1]) {
+                    legacyTier++;
+                }
+                words[wordCount] = (WordEntry){ lineOffset, length };
+                wordTiers[wordCount] = (unsigned char)(hasTierLines ? currentTier : legacyTier);
+                wordCount++;
+            }
+
+            lineNumber++;
+            lineOffset = offset + (uint32_t)i + 1;
+            lineLength = 0;
+            lastChar = '\0';
+        }
+        offset += (uint32_t)bytesRead;
+    }
+    fclose(allWords);
+
+    // lay out the header followed by every word grouped by tier, which is exactly what's saved as the sidecar
+    uint32_t tierCounts[NUM_TIERS] = { 0 };
+    uint32_t pickableCount = 0;
+    for (uint32_t i = 0; i < wordCount && !hasFailed; i++) {
+        if (wordTiers[i] != NO_TIER) {
+            tierCounts[wordTiers[i]]++;
+            pickableCount++;
+        }
+    }
+    size_t indexSize = sizeof(WordIndexHeader) + (size_t)pickableCount * sizeof(WordEntry);
+    WordIndexHeader* header = hasFailed ? NULL : calloc(1, indexSize);
+    if (header == NULL) {
+        if (!hasFailed) fprintf(stderr, "Memory allocation failed!\n");
+        free(words);
+        free(wordTiers);
+        return 0;
+    }
+    header->magic = WORD_INDEX_MAGIC;
+    header->wordFileSize = wordFileSize;
+    header->wordFileTime = wordFileTime;
+
+    memcpy(header->tierCounts, tierCounts, sizeof(tierCounts));
+    uint32_t tierNext[NUM_TIERS];
+    uint32_t firstWord = 0;
+    for (int i = 0; i < NUM_TIERS; i++) {
+        tierNext[i] = firstWord;
+        firstWord += header->tierCounts[i];
+    }
+    WordEntry* entries = (WordEntry*)(header + 1);
+    for (uint32_t i = 0; i < wordCount; i++) {
+        if (wordTiers[i] != NO_TIER) entries[tierNext[wordTiers[i]]++] = words[i];
+    }
+    free(words);
+    free(wordTiers);
+
+    // save the index for next time, with one write (the game still works from the copy in memory if this fails)
+    FILE* sidecar = fopen(indexFile, "wb");
+    if (sidecar != NULL) {
+        size_t written = fwrite(header, 1, indexSize, sidecar);
+        if (fclose(sidecar) != 0 || written != indexSize) {
+            remove(indexFile);
+        }
+    }
+
+    index->view = header;
+    index->header = header;
+    index->entries = entries;
+    return 1;
+}
+
+int findWordTier(const char* line, int length) {
+    const char* tierLines[NUM_TIERS] = { "[EASY]", "[MEDIUM]", "[HARD]", "[EXPERT]" };
+
+    for (int i = 0; i < NUM_TIERS; i++) {
+        if (length == (int)strlen(tierLines[i]) && strncmp(line, tierLines[i], length) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void closeWordIndex(WordIndex* index) {
+    if (index->isMapped) {
+        if (index->view != NULL) UnmapViewOfFile(index->view);
+        if (index->mapping != NULL) CloseHandle(index->mapping);
+        if (index->file != NULL) CloseHandle(index->file);
+    }
+    else {
+        free((void*)index->view);
+    }
+    memset(index, 0, sizeof(WordIndex));
+}
+
+// rand() only gives 15 bits on some compilers, so two calls are combined to reach every word of a big word bank
+uint32_t randomIndex(uint32_t count) {
+    uint32_t value = (uint32_t)rand() << 15 | (uint32_t)rand();
+    if (count > (1u << 30)) {
+        value = value << 15 | (uint32_t)rand();
+    }
+    return value % count;
+}
+
+void printDifficulty(Frame* frame, int difficultyLevel) {
     switch (difficultyLevel) {
     case 1:
-        printf("You are now playing EASY mode |\n");
-        printf("------------------------------+\n");
+        addToFrame(frame, "You are now playing EASY mode |\n");
+        addToFrame(frame, "------------------------------+\n");
         break;
     case 2:
-        printf("You are now playing MEDIUM mode |\n");
-        printf("--------------------------------+\n");
+        addToFrame(frame, "You are now playing MEDIUM mode |\n");
+        addToFrame(frame, "--------------------------------+\n");
         break;
     case 3:
-        printf("You are now playing HARD mode |\n");
-        printf("------------------------------+\n");
+        addToFrame(frame, "You are now playing HARD mode |\n");
+        addToFrame(frame, "------------------------------+\n");
         break;
     case 4:
-        printf("You are now playing EXPERT mode |\n");
-        printf("--------------------------------+\n");
+        addToFrame(frame, "You are now playing EXPERT mode |\n");
+        addToFrame(frame, "--------------------------------+\n");
     }
-    printf("\n");
+    addToFrame(frame, "\n");
 }
 
-void printHangman(int numGuesses) {
-    const char* spriteFileArr[] = {
+int loadSprites(void) {
+    const char* spriteFileArr[NUM_SPRITES] = {
         "attempt1.txt",
         "attempt2.txt",
         "attempt3.txt",
@@ -201,50 +790,104 @@ void printHangman(int numGuesses) {
         "attempt7.txt",
         "attempt8.txt"
     };
-    const char* spriteFile = spriteFileArr[numGuesses]; // loading in the correct file to use based on the attempts used so far
+    size_t length = 0;
 
-    FILE* hangman = fopen(spriteFile, "r");
-    if (hangman == NULL) {
-        fprintf(stderr, "An error occurred trying to print the hangman from %s.\n", spriteFile);
-        return;
-    }
+    sprites.text = NULL;
+    for (int i = 0; i < NUM_SPRITES; i++) {
+        sprites.offsets[i] = length;
+
+        // a missing sprite is reported now and then just left blank, rather than failing on every redraw
+        FILE* hangman = fopen(spriteFileArr[i], "rb");
+        if (hangman == NULL) {
+            fprintf(stderr, "An error occurred trying to load the hangman from %s.\n", spriteFileArr[i]);
+            continue;
+        }
 
-    // printing the appropriate hangman sprite based on the current attempt number
-    char ch;
-    while ((ch = fgetc(hangman)) != EOF) {
-        putchar(ch);
+        long fileSize = -1;
+        if (fseek(hangman, 0, SEEK_END) == 0) {
+            fileSize = ftell(hangman);
+            fseek(hangman, 0, SEEK_SET);
+        }
+        if (fileSize < 0) {
+            fprintf(stderr, "An error occurred trying to load the hangman from %s.\n", spriteFileArr[i]);
+            fclose(hangman);
+            continue;
+        }
+
+        // making room for the sprite and the newline printed after it
+        char* newText = realloc(sprites.text, length + fileSize + 1);
+        if (newText == NULL) {
+            fprintf(stderr, "Memory allocation failed!\n");
+            fclose(hangman);
+            freeSprites();
+            return 0;
+        }
+        sprites.text = newText;
+
+        size_t bytesRead = fread(sprites.text + length, 1, fileSize, hangman);
+        fclose(hangman);
+
+        // dropping carriage returns, since the console adds its own line endings when the frame is written
+        for (size_t j = 0; j < bytesRead; j++) {
+            if (sprites.text[sprites.offsets[i] + j] != '\r') {
+                sprites.text[length++] = sprites.text[sprites.offsets[i] + j];
+            }
+        }
+        sprites.text[length++] = '\n';
     }
-    printf("\n");
+    sprites.offsets[NUM_SPRITES] = length;
+
+    return 1;
+}
+
+void freeSprites(void) {
+    free(sprites.text);
+    sprites.text = NULL;
+}
+
+void printHangman(Frame* frame, int numGuesses) {
 
-    fclose(hangman);
+    // adding the appropriate hangman sprite based on the current attempt number
+    size_t spriteStart = sprites.offsets[numGuesses];
+    addTextToFrame(frame, sprites.text + spriteStart, sprites.offsets[numGuesses + 1] - spriteStart);
 }
 
 int endGame(int winCondition, int numGuesses) {
-    if (winCondition || numGuesses == 7) {
+    if (winCondition || numGuesses == MAX_WRONG_GUESSES) {
         return 1;
     }
     else {
         return 0;
     }
 }
+// starts a new frame with the game so far, followed by whatever happened on the last turn
+void drawGame(Frame* frame, const HangmanGame* game, Frame* message) {
+    startFrame(frame);
+    printDifficulty(frame, game->difficultyLevel);
+    printHangman(frame, game->numGuesses);
+    printBlanks(frame, game->word, game->letters.correctLetters);
+    printUsedLetters(frame, game->letters.guessedLetters & ~game->letters.answerLetters);
 
-void displayGameState(int* numGuesses, int difficultyLevel,
-    char* correctWord, char* usedLetters,
-    int* lifelinesRemaining, int* winCondition, char* correctLetters) {
-
-    printDifficulty(difficultyLevel);
-    printHangman(*numGuesses);
-    int numBlanks = printBlanks(correctWord, correctLetters) - 1;
-    printUsedLetters(usedLetters);
+    if (message->length > 0) {
+        addToFrame(frame, "\n");
+        addTextToFrame(frame, message->text, message->length);
+        message->length = 0;
+    }
+    addToFrame(frame, "\n");
+}
 
+/* adds the menu to the frame drawGame started and shows it, then plays the player's choice. anything to tell the
+    player about how it went is put in the message, to be drawn with the next frame. */
+void displayGameState(HangmanGame* game, Frame* message) {
     int choice = 0;
-    printf("Choose an option:\n");
-    printf("\t1) Guess a letter\n");
-    printf("\t2) Guess the word/phrase\n");
-    printf("\t3) Use a lifeline\n");
-    printf("Enter your choice: ");
+    addToFrame(&screen, "Choose an option:\n");
+    addToFrame(&screen, "\t1) Guess a letter\n");
+    addToFrame(&screen, "\t2) Guess the word/phrase\n");
+    addToFrame(&screen, "\t3) Use a lifeline\n");
+    addToFrame(&screen, "Enter your choice: ");
+    showFrame(&screen);
     if (scanf("%d", &choice) != 1) {
-        printf("Invalid input. Please enter 1, 2, or 3: ");
+        addToFrame(message, "Invalid input. Please enter 1, 2, or 3.\n");
         while (getchar() != '\n');
         return;
     }
@@ -257,151 +900,114 @@ void displayGameState(int* numGuesses, int difficultyLevel,
     case 1:
         printf("What letter would you like to guess? ");
         if (scanf(" %c", &letterGuess) != 1) {
-            printf("Invalid input. Please enter a letter: ");
+            addToFrame(message, "Invalid input. Please enter a letter.\n");
             while (getchar() != '\n');
             return;
         }
 
-        letterGuess = toupper(letterGuess); // disables case-sensitivity
-
-        for (int i = 0; i < NUM_ALPHABET; i++) {
-
-            // check if the letter is already not a part of usedLetters
-            if (letterGuess == usedLetters[i]) {
-                printf("You already guessed that letter!\n");
-                return;
-            }
-        }
-
-        if (checkGuessLetter(letterGuess, correctWord, usedLetters, correctLetters)) {
-            int index = 0;
-            char* tempPtr = correctLetters;
-
-            // move to the end of the correctLetters array
-            while (*tempPtr != ' ') {
-                tempPtr++;
-                index++;
-            }
-            correctLetters[index] = letterGuess; // add the guessed letter to the array of correct letters
-
-            // player automatically wins if there are no more blank letters to guess
-            if (numBlanks == 0) {
-                *winCondition = 1;
-            }
-
-            printf("Correct!\n");
-        }
-        else {
-            printf("Wrong!\n");
-            (*numGuesses)++;
+        switch (guessLetter(game, letterGuess)) {
+        case GUESS_CORRECT:
+            addToFrame(message, "Correct!\n");
+            break;
+        case GUESS_WRONG:
+            addToFrame(message, "Wrong!\n");
+            break;
+        case GUESS_REPEATED:
+            addToFrame(message, "You already guessed that letter!\n");
+            break;
+        case GUESS_NOT_A_LETTER:
+            addToFrame(message, "Please enter a letter from A-Z.\n");
+            break;
         }
         break;
     case 2:
         printf("Enter the word/phrase: ");
-        if (scanf(" %[^\n]", guessStr) != 1) {
-            printf("Invalid input!");
+        if (scanf(" %999[^\n]", guessStr) != 1) {
+            addToFrame(message, "Invalid input!\n");
             while (getchar() != '\n');
             return;
         }
 
-        stringToUpper(guessStr);
-
-        // compare the guessed word with the actual word
-        if (strcmp(guessStr, correctWord) == 0) {
-            *winCondition = 1; // player automatically wins if they match
-        }
-        else {
-            printf("Wrong!\n");
-            (*numGuesses)++;
-            return;
+        // compare the guessed word with the actual word (the player automatically wins if they match)
+        if (!guessPhrase(game, guessStr)) {
+            addToFrame(message, "Wrong!\n");
         }
         break;
     case 3:
-        if ((*lifelinesRemaining) > 0) {
-            if (*lifelinesRemaining == 1) {
-                printf("You have 1 lifeline remaining!\n");
+        if (game->lifelinesRemaining > 0) {
+            if (game->lifelinesRemaining == 1) {
+                addToFrame(&screen, "You have 1 lifeline remaining!\n");
             }
             else {
-                printf("You have %d lifelines remaining!\n", (*lifelinesRemaining));
+                addToFrame(&screen, "You have %d lifelines remaining!\n", game->lifelinesRemaining);
             }
 
             // user inputs a lifeline to use thru a menu
             int lifelineInput = 0;
-            printf("What lifeline would you like to use? ");
-            printf("Choose a lifeline:\n");
-            printf("\t1) Reveal a letter\n");
-            printf("\t2) Have another guess\n");
-            printf("Enter an option: ");
+            addToFrame(&screen, "What lifeline would you like to use? ");
+            addToFrame(&screen, "Choose a lifeline:\n");
+            addToFrame(&screen, "\t1) Reveal a letter\n");
+            addToFrame(&screen, "\t2) Have another guess\n");
+            addToFrame(&screen, "\t3) Narrow it down\n");
+            addToFrame(&screen, "Enter an option: ");
+            showFrame(&screen);
             if (scanf("%d", &lifelineInput) != 1) {
-                printf("Not a valid input!\n");
+                addToFrame(message, "Not a valid input!\n");
                 while (getchar() != '\n');
                 return;
             }
 
-            switch (lifelineInput) {
-            case 1: // revealing a letter
+            // the word bank is only indexed once someone asks for it, then kept for the rest of the game
+            if (lifelineInput == NARROW_DOWN && game->candidates == NULL) {
+                if (candidateIndex.lengths == NULL && !buildCandidateIndex(&candidateIndex)) {
+                    addToFrame(message, "The word bank couldn't be searched!\n");
+                    return;
+                }
+                game->candidates = &candidateIndex;
+            }
 
-                // find a correct letter not already in the array of correct letters
-                for (int i = 0; i < strlen(correctWord) + 1; i++) {
-                    if (!existsInArr(correctWord, correctLetters[i])) {
-                        int index = 0;
-                        char* tempPtr = correctLetters;
-                        while (*tempPtr != ' ') {
-                            tempPtr++;
-                            index++;
-                        }
-                        correctLetters[index] = correctWord[i]; // add the correct letter to the array of correct letters
-                        break;
+            switch (useLifeline(game, lifelineInput)) {
+            case LIFELINE_USED:
+                if (lifelineInput == EXTRA_GUESS) {
+                    addToFrame(message, "The hangman lost a body part! You now have another guess.\n");
+                }
+                else if (lifelineInput == NARROW_DOWN) {
+                    if (game->matchingWords == 1) {
+                        addToFrame(message, "Only 1 word/phrase in the word bank still fits!\n");
+                    }
+                    else {
+                        addToFrame(message, "%u words/phrases in the word bank still fit.\n", game->matchingWords);
                     }
                 }
                 break;
-            case 2: // having another guess (simply just decrement the number of guesses used)
-                if (*numGuesses > 0) {
-                    printf("The hangman lost a body part! You now have another guess.\n");
-                    (*numGuesses)--;
-                }
-                else {
-                    printf("You need to have at least one incorrect guess first.\n");
-                    return;
-                }
+            case LIFELINE_NOT_NEEDED:
+                addToFrame(message, "You need to have at least one incorrect guess first.\n");
+                break;
+            case LIFELINE_UNKNOWN:
+                addToFrame(message, "Not a valid input!\n");
+                break;
+            case LIFELINE_FAILED:
+                addToFrame(message, "The word bank couldn't be searched!\n");
+                break;
+            case LIFELINE_NONE_LEFT:
                 break;
             }
-
-            (*lifelinesRemaining)--; // decrement the lifelines as one has been just used
         }
         else {
-            if (difficultyLevel == 4) {
-                printf("There are no lifelines in expert difficulty!\n");
+            if (game->difficultyLevel == 4) {
+                addToFrame(message, "There are no lifelines in expert difficulty!\n");
             }
             else {
-                printf("You have no lifelines remaining!\n");
+                addToFrame(message, "You have no lifelines remaining!\n");
             }
         }
         break;
     default:
-        printf("Please enter 1, 2, or 3.\n");
+        addToFrame(message, "Please enter 1, 2, or 3.\n");
         break;
     }
 }
 
-// iterate thru the string char by char to see if the char exists within it
-int existsInArr(char* arr, char value) {
-    for (int i = 0; i < strlen(arr) + 1; i++) {
-        if (arr[i] == value) {
-            return 1;
-        }
-    }
-    return 0;
-}
-
-// converts the user's guess to uppercase to not be case-sensitive input
-void stringToUpper(char* str) {
-    while (*str) {
-        *str = toupper((unsigned char)*str);
-        str++;
-    }
-}
-
 int getNumLifelines(int difficultyLevel) {
     switch (difficultyLevel) {
     case 1:
@@ -415,96 +1021,1744 @@ int getNumLifelines(int difficultyLevel) {
     }
 }
 
-// checks if the usedLetter is ALSO part of the word
-int checkCurrentChar(char letter, char* word) {
-    for (int i = 0; i < strlen(word) + 1; i++) {
-        if (letter == word[i]) {
-            return 1;
-        }
+// the bit for a letter in a LetterMask, or no bits at all if it isn't a letter
+LetterMask letterBit(char letter) {
+    letter = toupper((unsigned char)letter);
+    if (letter < 'A' || letter > 'Z') {
+        return 0;
     }
-    return 0;
+    return (LetterMask)1 << (letter - 'A');
+}
+
+// collects the letters of the word/phrase in one pass, before anything has been guessed
+void startLetterState(LetterState* letters, const char* word) {
+    letters->answerLetters = 0;
+    for (const char* c = word; *c != '\0'; c++) {
+        letters->answerLetters |= letterBit(*c);
+    }
+    letters->guessedLetters = 0;
+    letters->correctLetters = 0;
+    letters->remainingLetters = letters->answerLetters;
 }
 
 // will either print an underscore (to represent a blank letter) or the correctly guessed letters so far
-int printBlanks(char* word, char* correctLetters) {
+int printBlanks(Frame* frame, const char* word, LetterMask correctLetters) {
     int numBlanks = 0;
-    printf("   ");
+    addToFrame(frame, "   ");
 
     // traverse the entire word or phrase char by char
     while (*word != '\0') {
         if (*word != ' ') {
+            LetterMask bit = letterBit(*word);
 
-            // if the current letter of the word is also a correctly guessed letter, print the letter
-            if (checkCurrentChar(*word, correctLetters)) {
-                printf("%c ", *word);
+            // if the current letter of the word is also a correctly guessed letter, show the letter (anything that
+            // isn't a letter, like an apostrophe, can't be guessed so it's always shown)
+            if (bit == 0 || (correctLetters & bit)) {
+                char shown[2] = { *word, ' ' };
+                addTextToFrame(frame, shown, 2);
             }
-            else { // otherwise, print it as an underscore
-                printf("_ ");
+            else { // otherwise, show it as an underscore
+                addTextToFrame(frame, "_ ", 2);
                 numBlanks++;
             }
         }
         else {
-            printf("  ");
+            addTextToFrame(frame, "  ", 2);
         }
         word++;
     }
-    printf("\n\n");
+    addToFrame(frame, "\n\n");
     return numBlanks;
 }
 
-void printUsedLetters(char* usedLetters) {
-    printf("\n");
-    printf("Letters already used: ");
+void printUsedLetters(Frame* frame, LetterMask usedLetters) {
+    addToFrame(frame, "\n");
+    addToFrame(frame, "Letters already used: ");
     for (int i = 0; i < NUM_ALPHABET; i++) {
-        printf("%c ", usedLetters[i]);
+        if (usedLetters & ((LetterMask)1 << i)) {
+            char used[2] = { 'A' + i, ' ' };
+            addTextToFrame(frame, used, 2);
+        }
     }
-    printf("\n");
+    addToFrame(frame, "\n");
+}
+
+// records a guessed letter and returns whether it's part of the word
+int checkGuessLetter(char guess, LetterState* letters) {
+    LetterMask bit = letterBit(guess);
+
+    letters->guessedLetters |= bit;
+    letters->correctLetters = letters->guessedLetters & letters->answerLetters;
+    letters->remainingLetters = letters->answerLetters & ~letters->guessedLetters;
+    return (letters->answerLetters & bit) != 0;
 }
 
-int checkGuessLetter(char guess, char* correctStr, char* usedLetters) {
-    for (int i = 0; i < strlen(correctStr) + 1; i++) {
-        if (guess == correctStr[i]) {
-            return 1;
+// the first letter in the word/phrase that hasn't been guessed yet
+char findRevealLetter(const char* word, LetterMask remainingLetters) {
+    for (const char* c = word; *c != '\0'; c++) {
+        if (remainingLetters & letterBit(*c)) {
+            return toupper((unsigned char)*c);
         }
     }
+    return '\0';
+}
+
+void newGame(HangmanGame* game, const char* word, int difficultyLevel) {
+    game->word = word;
+    game->difficultyLevel = difficultyLevel;
+    startLetterState(&game->letters, word);
+    game->numGuesses = 0;
+    game->lifelinesRemaining = getNumLifelines(difficultyLevel);
+    game->winCondition = 0;
+    game->candidates = NULL;
+    game->matchingWords = 0;
+}
+
+GuessResult guessLetter(HangmanGame* game, char letter) {
+    LetterMask bit = letterBit(letter);
+    if (bit == 0) {
+        return GUESS_NOT_A_LETTER;
+    }
 
-    // add the incorrectly guessed letter to the usedLetters array
-    int i = 0;
-    while (usedLetters[i] != ' ') {
-        i++;
+    // a letter that's already been guessed (right or wrong) doesn't cost anything
+    if (game->letters.guessedLetters & bit) {
+        return GUESS_REPEATED;
     }
-    usedLetters[i] = guess;
-    return 0;
+
+    if (!checkGuessLetter(letter, &game->letters)) {
+        game->numGuesses++;
+        return GUESS_WRONG;
+    }
+
+    // player automatically wins if there are no more blank letters to guess
+    if (game->letters.remainingLetters == 0) {
+        game->winCondition = 1;
+    }
+    return GUESS_CORRECT;
 }
 
-void gameLoop(char* correctWord, int difficultyLevel, int* winCondition) {
-    int numGuesses = 0;
-    int lifelinesRemaining = getNumLifelines(difficultyLevel);
-    char usedLetters[NUM_ALPHABET], correctLetters[NUM_ALPHABET];
+// returns whether the phrase matches the word, ignoring case
+int guessPhrase(HangmanGame* game, const char* phrase) {
+    const char* word = game->word;
+    while (*word != '\0' && toupper((unsigned char)*word) == toupper((unsigned char)*phrase)) {
+        word++;
+        phrase++;
+    }
 
-    for (int i = 0; i < NUM_ALPHABET; i++) {
-        usedLetters[i] = ' ';
-        correctLetters[i] = ' ';
+    if (*word == '\0' && *phrase == '\0') {
+        game->winCondition = 1;
+        return 1;
     }
+    game->numGuesses++;
+    return 0;
+}
 
-    while (1) {
-        displayGameState(&numGuesses, difficultyLevel, correctWord,
-            usedLetters, &lifelinesRemaining, winCondition, 
-            correctLetters);
-        Sleep(1000);
+LifelineResult useLifeline(HangmanGame* game, Lifeline lifeline) {
+    if (game->lifelinesRemaining <= 0) {
+        return LIFELINE_NONE_LEFT;
+    }
 
-        // check if the game has met either the winning or losing condition to end the game
-        if (endGame(*winCondition, numGuesses)) {
-            break;
+    switch (lifeline) {
+    case REVEAL_LETTER:
+
+        // reveal the first letter of the word/phrase that's still a blank, as if the player had guessed it
+        checkGuessLetter(findRevealLetter(game->word, game->letters.remainingLetters), &game->letters);
+        if (game->letters.remainingLetters == 0) {
+            game->winCondition = 1;
+        }
+        break;
+    case EXTRA_GUESS: // having another guess (simply just decrement the number of guesses used)
+        if (game->numGuesses == 0) {
+            return LIFELINE_NOT_NEEDED;
+        }
+        game->numGuesses--;
+        break;
+    case NARROW_DOWN:
+        if (game->candidates == NULL) {
+            return LIFELINE_UNKNOWN;
+        }
+        game->matchingWords = countCandidates(game->candidates, game);
+        if (game->matchingWords == UINT32_MAX) {
+            game->matchingWords = 0;
+            return LIFELINE_FAILED;
         }
-        system("cls");
+        break;
+    default:
+        return LIFELINE_UNKNOWN;
     }
 
-    // reveal the correct word if the game has been lost
-    if (!(*winCondition)) {
-        system("cls");
-        printDifficulty(difficultyLevel);
-        printHangman(7);
-        printf("\n\nThe word was %s\n", correctWord);
-    }
-}
\ No newline at end of file
+    game->lifelinesRemaining--; // decrement the lifelines as one has been just used
+    return LIFELINE_USED;
+}
+
+void gameLoop(char* correctWord, int difficultyLevel, int* winCondition) {
+    HangmanGame game;
+    newGame(&game, correctWord, difficultyLevel);
+    Frame message = { 0 }; // what happened on the last turn
+
+    // check if the game has met either the winning or losing condition to end the game
+    while (!endGame(game.winCondition, game.numGuesses)) {
+        drawGame(&screen, &game, &message);
+        displayGameState(&game, &message);
+        if (turnDelay > 0) {
+            Sleep(turnDelay);
+        }
+    }
+    *winCondition = game.winCondition;
+
+    // the last frame shows how the game ended, with every letter filled in (a phrase guessed whole never had them
+    // guessed one by one) and the correct word revealed if the game has been lost
+    if (*winCondition) {
+        game.letters.correctLetters = game.letters.answerLetters;
+    }
+    drawGame(&screen, &game, &message);
+    if (!(*winCondition)) {
+        addToFrame(&screen, "The word was %s\n\n", correctWord);
+    }
+    showFrame(&screen);
+    free(message.text);
+}
+
+/* turns on escape sequences for the console, so each frame can clear the last one itself instead of running cls in
+    a new process. output that isn't going to a console (like a script playing the game) is never cleared. */
+int enableVirtualTerminal(void) {
+    HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD mode;
+    if (!GetConsoleMode(console, &mode)) {
+        return 0;
+    }
+    return SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING) != 0;
+}
+
+void startFrame(Frame* frame) {
+    frame->length = 0;
+    if (clearWithEscape) {
+        addTextToFrame(frame, CLEAR_SCREEN, sizeof(CLEAR_SCREEN) - 1);
+    }
+}
+
+// makes sure there's room for extra more characters (and a '\0' after them, for vsnprintf)
+int reserveFrame(Frame* frame, size_t extra) {
+    if (frame->length + extra < frame->capacity) {
+        return 1;
+    }
+    size_t capacity = frame->capacity == 0 ? FRAME_START_SIZE : frame->capacity;
+    while (frame->length + extra >= capacity) {
+        capacity *= 2;
+    }
+
+    char* text = realloc(frame->text, capacity);
+    if (text == NULL) {
+        fprintf(stderr, "Memory allocation failed!\n");
+        return 0;
+    }
+    frame->text = text;
+    frame->capacity = capacity;
+    return 1;
+}
+
+void addToFrame(Frame* frame, const char* format, ...) {
+    if (!reserveFrame(frame, 0)) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(frame->text + frame->length, frame->capacity - frame->length, format, args);
+    va_end(args);
+    if (length <= 0) {
+        return;
+    }
+
+    // if it didn't all fit, make room and write it again
+    if (frame->length + length >= frame->capacity) {
+        if (!reserveFrame(frame, length)) {
+            return;
+        }
+        va_start(args, format);
+        vsnprintf(frame->text + frame->length, frame->capacity - frame->length, format, args);
+        va_end(args);
+    }
+    frame->length += length;
+}
+
+void addTextToFrame(Frame* frame, const char* text, size_t length) {
+    if (length == 0 || !reserveFrame(frame, length)) {
+        return;
+    }
+    memcpy(frame->text + frame->length, text, length);
+    frame->length += length;
+}
+
+// writes the whole frame to the console in one go, then starts the next one empty
+void showFrame(Frame* frame) {
+    if (frame->length > 0) {
+        fwrite(frame->text, 1, frame->length, stdout);
+    }
+    fflush(stdout);
+    frame->length = 0;
+}
+
+int loadWordBank(WordBank* bank) {
+    memset(bank, 0, sizeof(WordBank));
+
+    WordIndex index;
+    if (!openWordIndex(&index, WORD_FILE, WORD_INDEX_FILE)) {
+        return 0;
+    }
+    for (int i = 0; i < NUM_TIERS; i++) {
+        bank->tierCounts[i] = index.header->tierCounts[i];
+        bank->wordCount += index.header->tierCounts[i];
+    }
+
+    // reading the whole word bank in one go, then copying each word out of it in index order
+    size_t fileSize = (size_t)index.header->wordFileSize;
+    char* fileText = malloc(fileSize + 1);
+    size_t textSize = 0;
+    for (uint32_t i = 0; i < bank->wordCount; i++) {
+        textSize += index.entries[i].length + 1;
+    }
+    bank->text = malloc(textSize + 1);
+    bank->words = malloc((bank->wordCount + 1) * sizeof(char*));
+    bank->wordLengths = malloc((bank->wordCount + 1) * sizeof(uint32_t));
+    if (fileText == NULL || bank->text == NULL || bank->words == NULL || bank->wordLengths == NULL) {
+        fprintf(stderr, "Memory allocation failed!\n");
+        free(fileText);
+        closeWordIndex(&index);
+        freeWordBank(bank);
+        return 0;
+    }
+
+    FILE* allWords = fopen(WORD_FILE, "rb");
+    if (allWords == NULL || fread(fileText, 1, fileSize, allWords) != fileSize) {
+        fprintf(stderr, "An error occurred trying to read allWords.txt\n");
+        if (allWords != NULL) fclose(allWords);
+        free(fileText);
+        closeWordIndex(&index);
+        freeWordBank(bank);
+        return 0;
+    }
+    fclose(allWords);
+
+    char* nextWord = bank->text;
+    for (uint32_t i = 0; i < bank->wordCount; i++) {
+        WordEntry entry = index.entries[i];
+        memcpy(nextWord, fileText + entry.offset, entry.length);
+        nextWord[entry.length] = '\0';
+        bank->words[i] = nextWord;
+        bank->wordLengths[i] = entry.length;
+        nextWord += entry.length + 1;
+    }
+
+    free(fileText);
+    closeWordIndex(&index);
+    return 1;
+}
+
+void freeWordBank(WordBank* bank) {
+    free(bank->text);
+    free((void*)bank->words);
+    free(bank->wordLengths);
+    memset(bank, 0, sizeof(WordBank));
+}
+
+int buildCandidateIndex(CandidateIndex* index) {
+    memset(index, 0, sizeof(CandidateIndex));
+    if (!loadWordBank(&index->bank)) {
+        return 0;
+    }
+    const WordBank* bank = &index->bank;
+
+    for (uint32_t i = 0; i < bank->wordCount; i++) {
+        if (bank->wordLengths[i] > index->maxLength) index->maxLength = bank->wordLengths[i];
+    }
+    index->byLength = malloc((bank->wordCount + 1) * sizeof(uint32_t));
+    index->lengths = calloc(index->maxLength + 1, sizeof(CandidateLength));
+    if (index->byLength == NULL || index->lengths == NULL) {
+        fprintf(stderr, "Memory allocation failed!\n");
+        freeCandidateIndex(index);
+        return 0;
+    }
+
+    // counting the words of each length, then placing each word after every shorter one (keeping the bank's order)
+    for (uint32_t i = 0; i < bank->wordCount; i++) {
+        index->lengths[bank->wordLengths[i]].count++;
+    }
+    uint32_t start = 0;
+    for (uint32_t length = 0; length <= index->maxLength; length++) {
+        CandidateLength* words = &index->lengths[length];
+        words->start = start;
+        words->blockCount = (words->count + 63) / 64;
+        start += words->count;
+        words->count = 0;
+
+        if (words->blockCount > 0) {
+            words->atPosition = calloc((size_t)length * CANDIDATE_CLASSES * words->blockCount + 1, sizeof(uint64_t));
+            words->anywhere = calloc((size_t)NUM_ALPHABET * words->blockCount, sizeof(uint64_t));
+            if (words->atPosition == NULL || words->anywhere == NULL) {
+                fprintf(stderr, "Memory allocation failed!\n");
+                freeCandidateIndex(index);
+                return 0;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < bank->wordCount; i++) {
+        CandidateLength* words = &index->lengths[bank->wordLengths[i]];
+        uint32_t bit = words->count++;
+        index->byLength[words->start + bit] = i;
+
+        uint64_t mask = (uint64_t)1 << (bit % 64);
+        for (uint32_t position = 0; position < bank->wordLengths[i]; position++) {
+            char c = bank->words[i][position];
+            int letter = c == ' ' ? CANDIDATE_SPACE : CANDIDATE_OTHER;
+            if (letterBit(c) != 0) {
+                letter = toupper((unsigned char)c) - 'A';
+                words->anywhere[(size_t)letter * words->blockCount + bit / 64] |= mask;
+            }
+            words->atPosition[((size_t)position * CANDIDATE_CLASSES + letter) * words->blockCount + bit / 64] |= mask;
+        }
+    }
+    return 1;
+}
+
+void freeCandidateIndex(CandidateIndex* index) {
+    if (index->lengths != NULL) {
+        for (uint32_t length = 0; length <= index->maxLength; length++) {
+            free(index->lengths[length].atPosition);
+            free(index->lengths[length].anywhere);
+        }
+    }
+    free(index->lengths);
+    free(index->byLength);
+    freeWordBank(&index->bank);
+    memset(index, 0, sizeof(CandidateIndex));
+}
+
+/* a word still matches if it has every letter the player can see in the same place, a letter that hasn't been
+    guessed in every blank, and none of the wrong guesses anywhere (the same rules as matchesGame). each of those is
+    a bitset over the words of the answer's length, so every block of 64 words is checked against all of them at
+    once, stopping as soon as none of the 64 are left. returns UINT32_MAX if there's no memory to do it with. */
+uint32_t countCandidates(const CandidateIndex* index, const HangmanGame* game) {
+    uint32_t length = (uint32_t)strlen(game->word);
+    if (length > index->maxLength || index->lengths[length].count == 0) {
+        return 0;
+    }
+    const CandidateLength* words = &index->lengths[length];
+    LetterMask correctLetters = game->letters.correctLetters;
+    LetterMask wrongLetters = game->letters.guessedLetters & ~game->letters.answerLetters;
+
+    // every bitset a matching word has to be in, and every one it can't be in
+    const uint64_t** required = malloc(((size_t)length * (CANDIDATE_CLASSES + 1) + NUM_ALPHABET) * sizeof(uint64_t*));
+    if (required == NULL) {
+        fprintf(stderr, "Memory allocation failed!\n");
+        return UINT32_MAX;
+    }
+    const uint64_t** excluded = required + length;
+    uint32_t requiredCount = 0, excludedCount = 0;
+    int hasOther = 0;
+
+    for (uint32_t position = 0; position < length; position++) {
+        const uint64_t* atPosition = words->atPosition + (size_t)position * CANDIDATE_CLASSES * words->blockCount;
+        char c = game->word[position];
+        LetterMask bit = letterBit(c);
+
+        if (bit & correctLetters) {
+            required[requiredCount++] = atPosition + (size_t)(toupper((unsigned char)c) - 'A') * words->blockCount;
+        }
+        else if (bit == 0) {
+            required[requiredCount++] = atPosition + (size_t)(c == ' ' ? CANDIDATE_SPACE : CANDIDATE_OTHER) * words->blockCount;
+            hasOther |= c != ' ';
+        }
+        else {
+
+            // a blank can't be anything that isn't a letter, or a letter the player has already found
+            excluded[excludedCount++] = atPosition + (size_t)CANDIDATE_SPACE * words->blockCount;
+            excluded[excludedCount++] = atPosition + (size_t)CANDIDATE_OTHER * words->blockCount;
+            for (int letter = 0; letter < NUM_ALPHABET; letter++) {
+                if (correctLetters & ((LetterMask)1 << letter)) {
+                    excluded[excludedCount++] = atPosition + (size_t)letter * words->blockCount;
+                }
+            }
+        }
+    }
+    for (int letter = 0; letter < NUM_ALPHABET; letter++) {
+        if (wrongLetters & ((LetterMask)1 << letter)) {
+            excluded[excludedCount++] = words->anywhere + (size_t)letter * words->blockCount;
+        }
+    }
+
+    uint32_t matching = 0;
+    for (uint32_t block = 0; block < words->blockCount; block++) {
+        uint64_t bits = ~(uint64_t)0;
+        if (block == words->blockCount - 1 && words->count % 64 != 0) {
+            bits = ((uint64_t)1 << (words->count % 64)) - 1; // the last block isn't full
+        }
+        for (uint32_t i = 0; i < requiredCount && bits != 0; i++) {
+            bits &= required[i][block];
+        }
+        for (uint32_t i = 0; i < excludedCount && bits != 0; i++) {
+            bits &= ~excluded[i][block];
+        }
+
+        // punctuation other than a space all shares one bitset, so those words are checked character by character
+        if (hasOther) {
+            for (uint64_t remaining = bits; remaining != 0; remaining &= remaining - 1) {
+                int bit = lowestSetBit(remaining);
+                const char* word = index->bank.words[index->byLength[words->start + block * 64 + bit]];
+                for (uint32_t position = 0; position < length; position++) {
+                    if (letterBit(game->word[position]) == 0 && word[position] != game->word[position]) {
+                        bits &= ~((uint64_t)1 << bit);
+                        break;
+                    }
+                }
+            }
+        }
+        matching += (uint32_t)countSetBits(bits);
+    }
+
+    free(required);
+    return matching;
+}
+
+// the index of the lowest set bit of a word that isn't 0
+int lowestSetBit(uint64_t bits) {
+    unsigned long bit;
+#if defined(_M_X64) || defined(_M_ARM64)
+    _BitScanForward64(&bit, bits);
+#else
+    // 32 bit builds only have the 32 bit scan, so the high half is only scanned when the low half is empty
+    if (!_BitScanForward(&bit, (unsigned long)(bits & 0xFFFFFFFF))) {
+        _BitScanForward(&bit, (unsigned long)(bits >> 32));
+        bit += 32;
+    }
+#endif
+    return (int)bit;
+}
+
+int countSetBits(uint64_t bits) {
+#ifdef _M_X64
+    return (int)_mm_popcnt_u64(bits);
+#else
+    // without the 64 bit instruction, the bits are added up in pairs, then fours, then bytes, and the bytes all at once
+    bits = bits - ((bits >> 1) & 0x5555555555555555ull);
+    bits = (bits & 0x3333333333333333ull) + ((bits >> 2) & 0x3333333333333333ull);
+    bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return (int)((bits * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+int runBenchmark(int threadCount) {
+    WordBank bank;
+    if (!loadWordBank(&bank)) {
+        return 0;
+    }
+    if (bank.wordCount == 0) {
+        fprintf(stderr, "There are no words in %s\n", WORD_FILE);
+        freeWordBank(&bank);
+        return 0;
+    }
+
+    BenchJob job = { 0 };
+    job.bank = &bank;
+
+    if (!buildShapeGroups(&job)) {
+        freeWordBank(&bank);
+        return 0;
+    }
+
+    LARGE_INTEGER frequency, startTime, endTime;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&startTime);
+
+    job.nextWord = -1;
+    threadCount = runWorkers(runBenchWorker, &job, threadCount, bank.wordCount);
+
+    QueryPerformanceCounter(&endTime);
+    double seconds = (double)(endTime.QuadPart - startTime.QuadPart) / frequency.QuadPart;
+
+    const char* tierNames[NUM_TIERS] = { "EASY", "MEDIUM", "HARD", "EXPERT" };
+    printf("HANGMAN SOLVER BENCHMARK: %u words, %d threads\n\n", bank.wordCount, threadCount);
+    printf("%-10s %8s %10s %12s %12s\n", "Tier", "Words", "Win rate", "Avg wrong", "Avg turns");
+    for (int i = 0; i < NUM_TIERS; i++) {
+        if (bank.tierCounts[i] == 0) {
+            printf("%-10s %8u %10s %12s %12s\n", tierNames[i], 0u, "-", "-", "-");
+            continue;
+        }
+        double games = bank.tierCounts[i];
+        printf("%-10s %8u %9.1f%% %12.2f %12.2f\n", tierNames[i], bank.tierCounts[i], 100.0 * job.wins[i] / games,
+            job.wrongGuesses[i] / games, job.turns[i] / games);
+    }
+    printf("\n%u games in %.3f s (%.0f games/sec)\n", bank.wordCount, seconds, seconds > 0 ? bank.wordCount / seconds : 0.0);
+
+    freeShapeGroups(&job);
+    freeWordBank(&bank);
+    return 1;
+}
+
+int buildShapeGroups(BenchJob* job) {
+    const WordBank* bank = job->bank;
+    uint32_t wordCount = bank->wordCount;
+
+    SortedWord* sorted = malloc(wordCount * sizeof(SortedWord));
+    job->groups = malloc(wordCount * sizeof(ShapeGroup));
+    job->byShape = malloc(wordCount * sizeof(uint32_t));
+    job->firstKeys = malloc(wordCount * sizeof(uint64_t));
+    if (sorted == NULL || job->groups == NULL || job->byShape == NULL || job->firstKeys == NULL) {
+        fprintf(stderr, "Memory allocation failed!\n");
+        free(sorted);
+        freeShapeGroups(job);
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < wordCount; i++) {
+        sorted[i] = (SortedWord){ bank->wordLengths[i], findShapeKey(bank->words[i]), 0, i };
+    }
+    qsort(sorted, wordCount, sizeof(SortedWord), compareSortedWords);
+
+    // finding the groups, and the largest one so every worker's candidate list is big enough
+    uint32_t groupCount = 0;
+    for (uint32_t i = 0; i < wordCount; i++) {
+        if (i == 0 || sorted[i].length != sorted[i - 1].length || sorted[i].shapeKey != sorted[i - 1].shapeKey) {
+            job->groups[groupCount++] = (ShapeGroup){ sorted[i].length, sorted[i].shapeKey, i, 0, '\0' };
+        }
+        job->groups[groupCount - 1].count++;
+    }
+    job->groupCount = groupCount;
+    job->largestGroup = 0;
+    for (uint32_t i = 0; i < groupCount; i++) {
+        if (job->groups[i].count > job->largestGroup) job->largestGroup = job->groups[i].count;
+    }
+
+    uint32_t* candidates = malloc(job->largestGroup * sizeof(uint32_t));
+    uint64_t* keys = malloc((size_t)NUM_ALPHABET * job->largestGroup * sizeof(uint64_t));
+    if (candidates == NULL || keys == NULL) {
+        fprintf(stderr, "Memory allocation failed!\n");
+        free(candidates);
+        free(keys);
+        free(sorted);
+        freeShapeGroups(job);
+        return 0;
+    }
+
+    // the first guess for each group, then the group sorted by where that letter appears in each word
+    for (uint32_t i = 0; i < groupCount; i++) {
+        ShapeGroup* group = &job->groups[i];
+        for (uint32_t j = 0; j < group->count; j++) {
+            candidates[j] = sorted[group->start + j].wordNumber;
+        }
+        group->firstLetter = group->count > 1 ? chooseSolverLetter(0, bank, candidates, group->count, keys, job->largestGroup) : '\0';
+
+        for (uint32_t j = 0; j < group->count; j++) {
+            SortedWord* word = &sorted[group->start + j];
+            word->firstKey = group->firstLetter != '\0' ? findLetterKey(bank->words[word->wordNumber], group->firstLetter) : 0;
+        }
+        qsort(sorted + group->start, group->count, sizeof(SortedWord), compareSortedWords);
+
+        for (uint32_t j = group->start; j < group->start + group->count; j++) {
+            job->byShape[j] = sorted[j].wordNumber;
+            job->firstKeys[j] = sorted[j].firstKey;
+        }
+    }
+
+    free(candidates);
+    free(keys);
+    free(sorted);
+    return 1;
+}
+
+void freeShapeGroups(BenchJob* job) {
+    free(job->groups);
+    free(job->byShape);
+    free(job->firstKeys);
+    job->groups = NULL;
+    job->byShape = NULL;
+    job->firstKeys = NULL;
+}
+
+// the group a word belongs to, found from its length and shape alone (which is all the player knows at the start)
+const ShapeGroup* findShapeGroup(const BenchJob* job, const char* word) {
+    SortedWord shape = { (uint32_t)strlen(word), findShapeKey(word), 0, 0 };
+    uint32_t low = 0, high = job->groupCount;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        SortedWord groupShape = { job->groups[middle].length, job->groups[middle].shapeKey, 0, 0 };
+        if (compareSortedWords(&groupShape, &shape) < 0) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    // a word that isn't in the word bank has no group
+    if (low == job->groupCount || job->groups[low].length != shape.length || job->groups[low].shapeKey != shape.shapeKey) {
+        return NULL;
+    }
+    return &job->groups[low];
+}
+
+// a key made from every character that isn't a letter and where it is, which the player can see from the start
+uint64_t findShapeKey(const char* word) {
+    uint64_t key = 0;
+    for (uint32_t position = 0; word[position] != '\0'; position++) {
+        if (letterBit(word[position]) == 0) {
+            key = NEXT_POSITION_KEY(key, position) ^ (unsigned char)word[position];
+        }
+    }
+    return key;
+}
+
+uint64_t findLetterKey(const char* word, char letter) {
+    uint64_t key = 0;
+    for (uint32_t position = 0; word[position] != '\0'; position++) {
+        if (toupper((unsigned char)word[position]) == letter) {
+            key = NEXT_POSITION_KEY(key, position);
+        }
+    }
+    return key;
+}
+
+int compareSortedWords(const void* a, const void* b) {
+    const SortedWord* first = a;
+    const SortedWord* second = b;
+    if (first->length != second->length) return (first->length > second->length) - (first->length < second->length);
+    if (first->shapeKey != second->shapeKey) return (first->shapeKey > second->shapeKey) - (first->shapeKey < second->shapeKey);
+    return (first->firstKey > second->firstKey) - (first->firstKey < second->firstKey);
+}
+
+VOID CALLBACK runBenchWorker(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work) {
+    playBenchGames(context);
+}
+
+/* runs the worker on threadCount threads at once (every processor if it's 0), including this one, and returns once
+    they've all finished. each worker claims the next item until none are left, the same way the batch conversion in
+    parseImage.c hands out images. if the thread pool isn't available, this thread does all the work. returns the
+    number of threads used. */
+int runWorkers(PTP_WORK_CALLBACK worker, void* context, int threadCount, uint32_t itemCount) {
+    if (threadCount <= 0) {
+        SYSTEM_INFO systemInfo;
+        GetSystemInfo(&systemInfo);
+        threadCount = (int)systemInfo.dwNumberOfProcessors;
+    }
+    if (threadCount > MAX_BENCH_THREADS) threadCount = MAX_BENCH_THREADS;
+    if ((uint32_t)threadCount > itemCount) threadCount = itemCount > 0 ? (int)itemCount : 1;
+
+    PTP_WORK work = threadCount > 1 ? CreateThreadpoolWork(worker, context, NULL) : NULL;
+    if (work != NULL) {
+        for (int i = 1; i < threadCount; i++) {
+            SubmitThreadpoolWork(work);
+        }
+    }
+    worker(NULL, context, NULL);
+    if (work != NULL) {
+        WaitForThreadpoolWorkCallbacks(work, FALSE);
+        CloseThreadpoolWork(work);
+    }
+    return work != NULL ? threadCount : 1;
+}
+
+void playBenchGames(BenchJob* job) {
+    const WordBank* bank = job->bank;
+
+    // each thread has its own candidate list and position keys, big enough for the largest group of same-length words
+    uint32_t* candidates = malloc(job->largestGroup * sizeof(uint32_t));
+    uint64_t* keys = malloc((size_t)NUM_ALPHABET * job->largestGroup * sizeof(uint64_t));
+    if (candidates == NULL || keys == NULL) {
+        fprintf(stderr, "Memory allocation failed!\n");
+        free(candidates);
+        free(keys);
+        return;
+    }
+
+    // the results are added up here, then added to the shared totals once at the end
+    LONG wins[NUM_TIERS] = { 0 }, wrongGuesses[NUM_TIERS] = { 0 }, turns[NUM_TIERS] = { 0 };
+
+    // keep claiming the next word in the bank until every word has been played, each at its own tier's difficulty
+    LONG wordNumber;
+    while ((wordNumber = InterlockedIncrement(&job->nextWord)) < (LONG)bank->wordCount) {
+        int tier = 0;
+        uint32_t tierEnd = bank->tierCounts[0];
+        while ((uint32_t)wordNumber >= tierEnd) {
+            tier++;
+            tierEnd += bank->tierCounts[tier];
+        }
+
+        HangmanGame game;
+        newGame(&game, bank->words[wordNumber], tier + 1);
+        turns[tier] += playSolverGame(job, &game, candidates, keys);
+        wins[tier] += game.winCondition;
+        wrongGuesses[tier] += game.numGuesses;
+    }
+
+    for (int i = 0; i < NUM_TIERS; i++) {
+        InterlockedExchangeAdd(&job->wins[i], wins[i]);
+        InterlockedExchangeAdd(&job->wrongGuesses[i], wrongGuesses[i]);
+        InterlockedExchangeAdd(&job->turns[i], turns[i]);
+    }
+    free(candidates);
+    free(keys);
+}
+
+/* plays a game using only what a player could see: the blanks, the letters guessed so far, and the word bank.
+    every turn it narrows down the words that could still be the answer, then guesses the letter that splits them
+    into the most evenly sized groups (by where that letter appears), which is the guess that gives the most
+    information. it guesses the word once only one is left, and saves a lifeline for when one more wrong guess would
+    lose. returns the number of guesses it took. */
+int playSolverGame(const BenchJob* job, HangmanGame* game, uint32_t* candidates, uint64_t* keys) {
+    const WordBank* bank = job->bank;
+    const ShapeGroup* group = findShapeGroup(job, game->word);
+    uint32_t count = 0;
+    int turns = 0;
+
+    if (group != NULL) {
+        uint32_t start = group->start, end = group->start + group->count;
+
+        /* the first guess is the same for every word in the group, and once it's made the blanks show where that
+            letter is, which narrows the group down to the words with the same key without checking each one */
+        if (group->firstLetter != '\0') {
+            guessLetter(game, group->firstLetter);
+            turns++;
+
+            uint64_t revealedKey = findLetterKey(game->word, group->firstLetter);
+            uint32_t low = group->start, high = end;
+            while (low < high) {
+                uint32_t middle = low + (high - low) / 2;
+                if (job->firstKeys[middle] < revealedKey) low = middle + 1;
+                else high = middle;
+            }
+            start = low;
+            high = end;
+            while (low < high) {
+                uint32_t middle = low + (high - low) / 2;
+                if (job->firstKeys[middle] <= revealedKey) low = middle + 1;
+                else high = middle;
+            }
+            end = low;
+        }
+
+        for (uint32_t i = start; i < end; i++) {
+            candidates[count++] = job->byShape[i];
+        }
+    }
+
+    while (!endGame(game->winCondition, game->numGuesses)) {
+
+        // dropping the words that don't fit what's been revealed so far
+        uint32_t kept = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            if (matchesGame(bank->words[candidates[i]], game)) {
+                candidates[kept++] = candidates[i];
+            }
+        }
+        count = kept;
+
+        if (game->numGuesses == MAX_WRONG_GUESSES - 1 && game->lifelinesRemaining > 0) {
+            useLifeline(game, EXTRA_GUESS);
+        }
+
+        char letter = chooseSolverLetter(game->letters.guessedLetters, bank, candidates, count, keys, job->largestGroup);
+        if (letter == '\0' && count == 0) {
+            break;
+        }
+        turns++;
+        if (letter == '\0') {
+
+            // every word left looks the same to the player, so there's nothing left to do but guess it
+            if (!guessPhrase(game, bank->words[candidates[0]])) {
+                count = 0;
+            }
+        }
+        else {
+            guessLetter(game, letter);
+        }
+    }
+    return turns;
+}
+
+// whether a word from the word bank (of the same length) could still be the answer, given the blanks and the guesses
+int matchesGame(const char* candidate, const HangmanGame* game) {
+    for (const char* c = game->word; *c != '\0'; c++, candidate++) {
+        LetterMask bit = letterBit(*c);
+
+        // anything that isn't a letter, and any letter that's been guessed, is shown to the player and has to match
+        if (bit == 0 || (game->letters.correctLetters & bit)) {
+            if (toupper((unsigned char)*candidate) != toupper((unsigned char)*c)) {
+                return 0;
+            }
+        }
+        else {
+
+            // a blank can only be a letter that hasn't been guessed yet
+            LetterMask candidateBit = letterBit(*candidate);
+            if (candidateBit == 0 || (game->letters.guessedLetters & candidateBit)) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/* returns the letter whose guess splits the candidates into the most even groups, or '\0' if no letter splits them
+    at all (when one candidate is left, or they're all the same word). each candidate gets a key per letter made from
+    the positions that letter appears at, so candidates with equal keys would get the same answer from that guess. */
+char chooseSolverLetter(LetterMask guessedLetters, const WordBank* bank, const uint32_t* candidates, uint32_t count,
+    uint64_t* keys, uint32_t keyStride) {
+    LetterMask unguessed = ((1u << NUM_ALPHABET) - 1) & ~guessedLetters;
+
+    // with no candidates left (if the word isn't in the bank) the most common letters are guessed first
+    if (count == 0) {
+        for (const char* c = COMMON_LETTERS; *c != '\0'; c++) {
+            if (unguessed & letterBit(*c)) {
+                return *c;
+            }
+        }
+        return '\0';
+    }
+
+    for (int i = 0; i < NUM_ALPHABET; i++) {
+        if (unguessed & ((LetterMask)1 << i)) {
+            memset(keys + (size_t)i * keyStride, 0, count * sizeof(uint64_t));
+        }
+    }
+    for (uint32_t j = 0; j < count; j++) {
+        const char* word = bank->words[candidates[j]];
+        for (uint32_t position = 0; word[position] != '\0'; position++) {
+            LetterMask bit = letterBit(word[position]);
+            if (unguessed & bit) {
+                uint64_t* key = keys + (size_t)(toupper((unsigned char)word[position]) - 'A') * keyStride + j;
+                *key = NEXT_POSITION_KEY(*key, position);
+            }
+        }
+    }
+
+    // the best letter leaves the smallest expected group, which is the sum of each group's size times its log
+    char bestLetter = '\0';
+    double bestScore = count * log2(count);
+    for (const char* c = COMMON_LETTERS; *c != '\0'; c++) {
+        if (!(unguessed & letterBit(*c))) {
+            continue;
+        }
+
+        // the candidates without the letter (a key of 0) are one group, so only the rest need sorting into groups
+        uint64_t* letterKeys = keys + (size_t)(*c - 'A') * keyStride;
+        uint32_t withLetter = 0;
+        for (uint32_t j = 0; j < count; j++) {
+            if (letterKeys[j] != 0) {
+                letterKeys[withLetter++] = letterKeys[j];
+            }
+        }
+        if (withLetter == 0) {
+            continue;
+        }
+        qsort(letterKeys, withLetter, sizeof(uint64_t), compareKeys);
+
+        uint32_t withoutLetter = count - withLetter;
+        double score = withoutLetter > 0 ? withoutLetter * log2(withoutLetter) : 0;
+        uint32_t groupStart = 0;
+        for (uint32_t j = 1; j <= withLetter; j++) {
+            if (j == withLetter || letterKeys[j] != letterKeys[groupStart]) {
+                uint32_t groupSize = j - groupStart;
+                score += groupSize * log2(groupSize);
+                groupStart = j;
+            }
+        }
+        if (score < bestScore) {
+            bestScore = score;
+            bestLetter = *c;
+        }
+    }
+    return bestLetter;
+}
+
+int compareKeys(const void* a, const void* b) {
+    uint64_t first = *(const uint64_t*)a, second = *(const uint64_t*)b;
+    return (first > second) - (first < second);
+}
+
+/* the server reads one command per line and answers each with one line. the commands are:
+        NEW <difficulty 1-4>     start a game with a random word from that difficulty
+        GUESS <letter>
+        PHRASE <word/phrase>
+        LIFELINE <1 to reveal a letter, 2 for another guess>
+        QUIT
+    every answer to a game command is "<result> <PLAYING, WON or LOST> <wrong guesses> <lifelines left> <blanks>",
+    where the blanks show each letter not guessed yet as an underscore (or the whole word/phrase once it's lost).
+    anything else is answered with "ERROR <reason>". */
+int runServer(const char* socketFile) {
+    HangmanServer server = { 0 };
+    srand(time(NULL));
+
+    if (!loadWordBank(&server.bank)) {
+        return 0;
+    }
+    uint32_t tierStart = 0;
+    for (int i = 0; i < NUM_TIERS; i++) {
+        server.tierStarts[i] = tierStart;
+        tierStart += server.bank.tierCounts[i];
+    }
+
+    // a reply shows the whole word/phrase, so longer ones are cut short to fit in a session's output
+    uint32_t longestWord = 0;
+    for (uint32_t i = 0; i < server.bank.wordCount; i++) {
+        if (server.bank.wordLengths[i] > longestWord) longestWord = server.bank.wordLengths[i];
+    }
+    if (longestWord > SESSION_BUFFER_SIZE - MAX_REPLY_EXTRA) longestWord = SESSION_BUFFER_SIZE - MAX_REPLY_EXTRA;
+    server.maxReplyLength = (int)longestWord + MAX_REPLY_EXTRA;
+
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        fprintf(stderr, "Winsock couldn't be started\n");
+        freeWordBank(&server.bank);
+        return 0;
+    }
+
+    SOCKET listener = openServerSocket(socketFile, 1);
+    if (listener == INVALID_SOCKET || !addServerSocket(&server, listener, NULL)) {
+        if (listener != INVALID_SOCKET) closesocket(listener);
+        WSACleanup();
+        freeWordBank(&server.bank);
+        return 0;
+    }
+    printf("Hosting hangman on %s\n", socketFile);
+    fflush(stdout);
+
+    // one thread waits on every socket at once, and only touches the ones that are ready
+    int succeeded = 1;
+    while (1) {
+        if (WSAPoll(server.pollFds, server.pollCount, -1) == SOCKET_ERROR) {
+            if (WSAGetLastError() == WSAEINTR) continue;
+            fprintf(stderr, "Waiting on the sockets failed (error %d)\n", WSAGetLastError());
+            succeeded = 0;
+            break;
+        }
+
+        // going backwards, so a closed session swapped in from the end has already been handled
+        for (int i = server.pollCount - 1; i >= 1; i--) {
+            Session* session = server.sessions[i];
+            short events = server.pollFds[i].revents;
+            if (events == 0) {
+                continue;
+            }
+
+            int isOpen = !(events & (POLLERR | POLLNVAL));
+            if (isOpen && (events & (POLLRDNORM | POLLHUP))) {
+                isOpen = readSession(session);
+            }
+            if (isOpen) {
+                handleSessionInput(&server, session);
+                isOpen = writeSession(session);
+            }
+
+            // a reply that's fully sent makes room for the replies to any commands still waiting (none are answered after a QUIT)
+            while (isOpen && !session->isClosing && session->outputLength == 0 && memchr(session->input, '\n', session->inputLength) != NULL) {
+                handleSessionInput(&server, session);
+                isOpen = writeSession(session);
+            }
+
+            if (!isOpen || (session->isClosing && session->outputLength == 0)) {
+                removeServerSocket(&server, i);
+                continue;
+            }
+
+            // only ask to read while there's room for more input, and only ask to write while there's output left
+            server.pollFds[i].events = 0;
+            if (!session->isClosing && session->inputLength < SESSION_BUFFER_SIZE) {
+                server.pollFds[i].events |= POLLRDNORM;
+            }
+            if (session->outputLength > 0) {
+                server.pollFds[i].events |= POLLWRNORM;
+            }
+        }
+
+        if (server.pollFds[0].revents & POLLRDNORM) {
+            acceptSessions(&server);
+        }
+    }
+
+    for (int i = server.pollCount - 1; i >= 1; i--) {
+        removeServerSocket(&server, i);
+    }
+    closesocket(listener);
+    free(server.pollFds);
+    free(server.sessions);
+    freeSessionPool(&server.pool);
+    WSACleanup();
+    freeWordBank(&server.bank);
+    return succeeded;
+}
+
+int addServerSocket(HangmanServer* server, SOCKET socket, Session* session) {
+
+    // grow both lists together, doubling their size whenever they fill up
+    if (server->pollCount == server->pollCapacity) {
+        int newCapacity = server->pollCapacity == 0 ? 64 : server->pollCapacity * 2;
+        WSAPOLLFD* pollFds = realloc(server->pollFds, newCapacity * sizeof(WSAPOLLFD));
+        if (pollFds != NULL) server->pollFds = pollFds;
+        Session** sessions = realloc(server->sessions, newCapacity * sizeof(Session*));
+        if (sessions != NULL) server->sessions = sessions;
+
+        if (pollFds == NULL || sessions == NULL) {
+            fprintf(stderr, "Memory allocation failed!\n");
+            return 0;
+        }
+        server->pollCapacity = newCapacity;
+    }
+
+    server->pollFds[server->pollCount].fd = socket;
+    server->pollFds[server->pollCount].events = POLLRDNORM;
+    server->pollFds[server->pollCount].revents = 0;
+    server->sessions[server->pollCount] = session;
+    server->pollCount++;
+    return 1;
+}
+
+// closes a session, moving the last one into its place so the lists stay packed
+void removeServerSocket(HangmanServer* server, int index) {
+    closesocket(server->pollFds[index].fd);
+    freeSession(&server->pool, server->sessions[index]);
+
+    server->pollCount--;
+    server->pollFds[index] = server->pollFds[server->pollCount];
+    server->sessions[index] = server->sessions[server->pollCount];
+}
+
+void acceptSessions(HangmanServer* server) {
+
+    // taking every waiting connection, until accept says there are none left
+    while (1) {
+        SOCKET socket = accept(server->pollFds[0].fd, NULL, NULL);
+        if (socket == INVALID_SOCKET) {
+            if (WSAGetLastError() != WSAEWOULDBLOCK) {
+                fprintf(stderr, "A connection couldn't be accepted (error %d)\n", WSAGetLastError());
+            }
+            return;
+        }
+
+        Session* session = allocateSession(&server->pool);
+        if (session == NULL || !setNonBlocking(socket) || !addServerSocket(server, socket, session)) {
+            if (session != NULL) freeSession(&server->pool, session);
+            closesocket(socket);
+            continue;
+        }
+        session->socket = socket;
+    }
+}
+
+// returns 0 once the connection has closed
+int readSession(Session* session) {
+    int received = recv(session->socket, session->input + session->inputLength, SESSION_BUFFER_SIZE - session->inputLength, 0);
+    if (received == SOCKET_ERROR) {
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+    }
+    if (received == 0) {
+        return 0;
+    }
+    session->inputLength += received;
+
+    // a full buffer without a single whole line in it can never be handled
+    if (session->inputLength == SESSION_BUFFER_SIZE && memchr(session->input, '\n', session->inputLength) == NULL) {
+        return 0;
+    }
+    return 1;
+}
+
+// sends as much of the output as the socket will take, and returns 0 if the connection has closed
+int writeSession(Session* session) {
+    while (session->outputSent < session->outputLength) {
+        int sent = send(session->socket, session->output + session->outputSent, session->outputLength - session->outputSent, 0);
+        if (sent == SOCKET_ERROR) {
+            return WSAGetLastError() == WSAEWOULDBLOCK;
+        }
+        session->outputSent += sent;
+    }
+    session->outputLength = 0;
+    session->outputSent = 0;
+    return 1;
+}
+
+// handles every whole line of input, as long as there's room in the output for the reply
+void handleSessionInput(HangmanServer* server, Session* session) {
+    int lineStart = 0;
+    char* lineEnd;
+    while (!session->isClosing && session->outputLength + server->maxReplyLength <= SESSION_BUFFER_SIZE &&
+        (lineEnd = memchr(session->input + lineStart, '\n', session->inputLength - lineStart)) != NULL) {
+        *lineEnd = '\0';
+        if (lineEnd > session->input + lineStart && lineEnd[-1] == '\r') {
+            lineEnd[-1] = '\0';
+        }
+        handleSessionLine(server, session, session->input + lineStart);
+        lineStart = (int)(lineEnd - session->input) + 1;
+    }
+
+    // nothing sent after a QUIT is answered, so it's thrown away instead of being left waiting for a reply that never comes
+    if (session->isClosing) {
+        session->inputLength = 0;
+        return;
+    }
+
+    // moving whatever's left to the front for the next read to add to
+    session->inputLength -= lineStart;
+    memmove(session->input, session->input + lineStart, session->inputLength);
+}
+
+void handleSessionLine(HangmanServer* server, Session* session, char* line) {
+    HangmanGame* game = &session->game;
+
+    if (strncmp(line, "NEW ", 4) == 0) {
+        int difficultyLevel = atoi(line + 4);
+        if (difficultyLevel < 1 || difficultyLevel > NUM_TIERS) {
+            writeSessionLine(session, "ERROR difficulty must be 1-4");
+            return;
+        }
+        uint32_t tierCount = server->bank.tierCounts[difficultyLevel - 1];
+        if (tierCount == 0) {
+            writeSessionLine(session, "ERROR no words for that difficulty");
+            return;
+        }
+
+        // every session plays from the same words in memory, so starting a game never touches the word file
+        newGame(game, server->bank.words[server->tierStarts[difficultyLevel - 1] + randomIndex(tierCount)], difficultyLevel);
+        session->hasGame = 1;
+        writeGameState(session, "NEW");
+        return;
+    }
+    if (strcmp(line, "QUIT") == 0) {
+        session->isClosing = 1;
+        return;
+    }
+
+    if (!session->hasGame) {
+        writeSessionLine(session, "ERROR no game");
+        return;
+    }
+    if (endGame(game->winCondition, game->numGuesses)) {
+        writeSessionLine(session, "ERROR game over");
+        return;
+    }
+
+    if (strncmp(line, "GUESS ", 6) == 0 && line[6] != '\0' && line[7] == '\0') {
+        const char* guessResults[] = { "CORRECT", "WRONG", "REPEATED", "INVALID" };
+        writeGameState(session, guessResults[guessLetter(game, line[6])]);
+    }
+    else if (strncmp(line, "PHRASE ", 7) == 0) {
+        writeGameState(session, guessPhrase(game, line + 7) ? "CORRECT" : "WRONG");
+    }
+    else if (strncmp(line, "LIFELINE ", 9) == 0) {
+        const char* lifelineResults[] = { "USED", "NONE_LEFT", "NOT_NEEDED", "INVALID", "FAILED" };
+        writeGameState(session, lifelineResults[useLifeline(game, atoi(line + 9))]);
+    }
+    else {
+        writeSessionLine(session, "ERROR unknown command");
+    }
+}
+
+void writeGameState(Session* session, const char* result) {
+    const HangmanGame* game = &session->game;
+    const char* status = game->winCondition ? "WON" : game->numGuesses >= MAX_WRONG_GUESSES ? "LOST" : "PLAYING";
+
+    char* reply = session->output + session->outputLength;
+    int replyLength = snprintf(reply, MAX_REPLY_EXTRA, "%s %s %d %d ", result, status, game->numGuesses, game->lifelinesRemaining);
+
+    // the blanks, cut short if they'd overflow the output
+    int isLost = strcmp(status, "LOST") == 0;
+    int spaceLeft = SESSION_BUFFER_SIZE - session->outputLength - replyLength - 1;
+    for (const char* c = game->word; *c != '\0' && spaceLeft > 0; c++, spaceLeft--) {
+        LetterMask bit = letterBit(*c);
+        reply[replyLength++] = isLost || bit == 0 || (game->letters.correctLetters & bit) ? *c : '_';
+    }
+    reply[replyLength++] = '\n';
+    session->outputLength += replyLength;
+}
+
+void writeSessionLine(Session* session, const char* line) {
+    session->outputLength += snprintf(session->output + session->outputLength, SESSION_BUFFER_SIZE - session->outputLength, "%s\n", line);
+}
+
+Session* allocateSession(SessionPool* pool) {
+
+    // carving a new slab into free sessions once every session handed out so far is in use
+    if (pool->freeList == NULL) {
+        Session** slabs = realloc(pool->slabs, (pool->slabCount + 1) * sizeof(Session*));
+        if (slabs == NULL) {
+            fprintf(stderr, "Memory allocation failed!\n");
+            return NULL;
+        }
+        pool->slabs = slabs;
+
+        Session* slab = malloc(SESSIONS_PER_SLAB * sizeof(Session));
+        if (slab == NULL) {
+            fprintf(stderr, "Memory allocation failed!\n");
+            return NULL;
+        }
+        pool->slabs[pool->slabCount++] = slab;
+        for (int i = SESSIONS_PER_SLAB - 1; i >= 0; i--) {
+            slab[i].nextFree = pool->freeList;
+            pool->freeList = &slab[i];
+        }
+    }
+
+    Session* session = pool->freeList;
+    pool->freeList = session->nextFree;
+    session->hasGame = 0;
+    session->isClosing = 0;
+    session->inputLength = 0;
+    session->outputLength = 0;
+    session->outputSent = 0;
+    return session;
+}
+
+void freeSession(SessionPool* pool, Session* session) {
+    session->nextFree = pool->freeList;
+    pool->freeList = session;
+}
+
+void freeSessionPool(SessionPool* pool) {
+    for (int i = 0; i < pool->slabCount; i++) {
+        free(pool->slabs[i]);
+    }
+    free(pool->slabs);
+    memset(pool, 0, sizeof(SessionPool));
+}
+
+int setNonBlocking(SOCKET socket) {
+    u_long isNonBlocking = 1;
+    return ioctlsocket(socket, FIONBIO, &isNonBlocking) == 0;
+}
+
+// listens on the socket file for the server, or connects to it for the client
+SOCKET openServerSocket(const char* socketFile, int isServer) {
+    SOCKADDR_UN address = { 0 };
+    address.sun_family = AF_UNIX;
+    if (strlen(socketFile) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "The socket file name %s is too long\n", socketFile);
+        return INVALID_SOCKET;
+    }
+    strcpy(address.sun_path, socketFile);
+
+    SOCKET newSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (newSocket == INVALID_SOCKET) {
+        fprintf(stderr, "A socket couldn't be made (error %d)\n", WSAGetLastError());
+        return INVALID_SOCKET;
+    }
+
+    if (isServer) {
+
+        // a socket file left behind by a server that didn't shut down cleanly would stop bind from working
+        remove(socketFile);
+        if (bind(newSocket, (SOCKADDR*)&address, sizeof(address)) == SOCKET_ERROR ||
+            listen(newSocket, SOMAXCONN) == SOCKET_ERROR || !setNonBlocking(newSocket)) {
+            fprintf(stderr, "Couldn't listen on %s (error %d)\n", socketFile, WSAGetLastError());
+            closesocket(newSocket);
+            return INVALID_SOCKET;
+        }
+    }
+    else if (connect(newSocket, (SOCKADDR*)&address, sizeof(address)) == SOCKET_ERROR || !setNonBlocking(newSocket)) {
+        fprintf(stderr, "Couldn't connect to %s (error %d)\n", socketFile, WSAGetLastError());
+        closesocket(newSocket);
+        return INVALID_SOCKET;
+    }
+    return newSocket;
+}
+
+/* opens sessionCount connections to the server and plays gamesPerSession games on each, all at the same time. every
+    connection cycles through the difficulties and guesses the most common letters first, which is enough to give the
+    server a realistic load to test against. */
+int runClient(int sessionCount, int gamesPerSession, const char* socketFile) {
+    if (sessionCount < 1 || gamesPerSession < 1) {
+        fprintf(stderr, "usage: hangman --client <sessions> <games per session> [socket file]\n");
+        return 0;
+    }
+
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        fprintf(stderr, "Winsock couldn't be started\n");
+        return 0;
+    }
+
+    ClientSession* clients = calloc(sessionCount, sizeof(ClientSession));
+    WSAPOLLFD* pollFds = calloc(sessionCount, sizeof(WSAPOLLFD));
+    if (clients == NULL || pollFds == NULL) {
+        fprintf(stderr, "Memory allocation failed!\n");
+        free(clients);
+        free(pollFds);
+        WSACleanup();
+        return 0;
+    }
+
+    LARGE_INTEGER frequency, startTime, endTime;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&startTime);
+
+    int openCount = 0;
+    for (int i = 0; i < sessionCount; i++) {
+        ClientSession* client = &clients[openCount];
+        client->socket = openServerSocket(socketFile, 0);
+        if (client->socket == INVALID_SOCKET) {
+            break;
+        }
+        client->gamesLeft = gamesPerSession;
+        client->difficultyLevel = i % NUM_TIERS + 1;
+        client->pipelinesQuit = i % 2;
+
+        char command[16];
+        sprintf(command, "NEW %d", client->difficultyLevel);
+        if (!sendClientLine(client, command)) {
+            closesocket(client->socket);
+            break;
+        }
+        pollFds[openCount].fd = client->socket;
+        pollFds[openCount].events = POLLRDNORM;
+        openCount++;
+    }
+    int succeeded = openCount == sessionCount;
+
+    long long gamesPlayed = 0, gamesWon = 0, turns = 0, errors = 0;
+    while (openCount > 0) {
+        if (WSAPoll(pollFds, openCount, -1) == SOCKET_ERROR) {
+            if (WSAGetLastError() == WSAEINTR) continue;
+            fprintf(stderr, "Waiting on the sockets failed (error %d)\n", WSAGetLastError());
+            succeeded = 0;
+            break;
+        }
+
+        for (int i = openCount - 1; i >= 0; i--) {
+            if (pollFds[i].revents == 0) {
+                continue;
+            }
+            ClientSession* client = &clients[i];
+            int isOpen = 1;
+
+            int received = recv(client->socket, client->input + client->inputLength, SESSION_BUFFER_SIZE - client->inputLength, 0);
+            if (received == 0 && client->isQuitting) {
+                isOpen = 0; // the server closed the connection without answering what came after the QUIT
+            }
+            else if (received == 0 || (received == SOCKET_ERROR && WSAGetLastError() != WSAEWOULDBLOCK)) {
+                isOpen = 0;
+                succeeded = 0;
+            }
+            else if (received > 0) {
+                client->inputLength += received;
+            }
+
+            // every reply is answered with the next command for that connection's game
+            char* lineEnd;
+            while (isOpen && (lineEnd = memchr(client->input, '\n', client->inputLength)) != NULL) {
+                *lineEnd = '\0';
+                char result[16], status[16];
+                if (client->isQuitting || sscanf(client->input, "%15s %15s", result, status) != 2 || strcmp(result, "ERROR") == 0) {
+                    fprintf(stderr, "The server replied: %s\n", client->input);
+                    errors++;
+                    isOpen = 0;
+                    break;
+                }
+                int lineLength = (int)(lineEnd - client->input) + 1;
+                client->inputLength -= lineLength;
+                memmove(client->input, client->input + lineLength, client->inputLength);
+
+                char command[16];
+                if (strcmp(status, "PLAYING") == 0) {
+                    if (client->nextLetter == NULL || *client->nextLetter == '\0') client->nextLetter = COMMON_LETTERS;
+                    sprintf(command, "GUESS %c", *client->nextLetter++);
+                    turns++;
+                }
+                else {
+                    gamesPlayed++;
+                    gamesWon += strcmp(status, "WON") == 0;
+                    client->nextLetter = COMMON_LETTERS;
+                    /* half the connections just quit. the other half send another command in the same write as the QUIT,
+                        which the server has to throw away, then wait for the server to close the connection on its end. */
+                    if (--client->gamesLeft == 0) {
+                        if (!client->pipelinesQuit) {
+                            sendClientLine(client, "QUIT");
+                            isOpen = 0;
+                        }
+                        else {
+                            client->isQuitting = 1;
+                            isOpen = sendClientLine(client, "QUIT\nNEW 1");
+                        }
+                        break;
+                    }
+                    client->difficultyLevel = client->difficultyLevel % NUM_TIERS + 1;
+                    sprintf(command, "NEW %d", client->difficultyLevel);
+                }
+                isOpen = sendClientLine(client, command);
+            }
+
+            // a finished connection is closed, and the last one is moved into its place
+            if (!isOpen) {
+                closesocket(client->socket);
+                openCount--;
+                clients[i] = clients[openCount];
+                pollFds[i] = pollFds[openCount];
+            }
+        }
+    }
+
+    QueryPerformanceCounter(&endTime);
+    double seconds = (double)(endTime.QuadPart - startTime.QuadPart) / frequency.QuadPart;
+    printf("%lld games (%lld won) over %d sessions, %lld guesses in %.3f s (%.0f guesses/sec)\n", gamesPlayed, gamesWon,
+        sessionCount, turns, seconds, seconds > 0 ? turns / seconds : 0.0);
+    if (errors > 0) {
+        printf("%lld errors\n", errors);
+    }
+
+    for (int i = 0; i < openCount; i++) {
+        closesocket(clients[i].socket);
+    }
+    free(clients);
+    free(pollFds);
+    WSACleanup();
+    return succeeded && errors == 0 && gamesPlayed == (long long)sessionCount * gamesPerSession;
+}
+
+int sendClientLine(ClientSession* client, const char* line) {
+    char buffer[SESSION_BUFFER_SIZE];
+    int length = snprintf(buffer, sizeof(buffer), "%s\n", line);
+
+    // the server answers each line before the next is sent, so the socket never has more than one command waiting in it
+    // (apart from a QUIT with a command behind it, which the server never answers)
+    int sent = 0;
+    while (sent < length) {
+        int result = send(client->socket, buffer + sent, length - sent, 0);
+        if (result == SOCKET_ERROR) {
+            if (WSAGetLastError() == WSAEWOULDBLOCK) continue;
+            return 0;
+        }
+        sent += result;
+    }
+    return 1;
+}
+
+/* a word's difficulty score adds up how many guesses (and wrong guesses) the solver needs to get it with no
+    lifelines, how many letters it has, and how rare each of its different letters is across the whole list (so a
+    word with more distinct letters, or with letters few other words have, scores higher). the words are sorted by
+    score and split into four equal tiers, easiest first. */
+int runTiering(const char* wordList, const char* wordFile, const char* indexFile, int threadCount) {
+    TierJob job = { 0 };
+    WordBank bank;
+    if (!loadWordList(&bank, wordList)) {
+        return 0;
+    }
+    if (bank.wordCount == 0) {
+        fprintf(stderr, "There are no words in %s\n", wordList);
+        freeWordBank(&bank);
+        return 0;
+    }
+
+    job.solver.bank = &bank;
+    job.scores = malloc(bank.wordCount * sizeof(WordScore));
+    if (job.scores == NULL) {
+        fprintf(stderr, "Memory allocation failed!\n");
+        freeWordBank(&bank);
+        return 0;
+    }
+    if (!buildShapeGroups(&job.solver)) {
+        free(job.scores);
+        freeWordBank(&bank);
+        return 0;
+    }
+
+    // a letter's rarity is how many bits it takes to say a word has it, so letters in fewer words are rarer
+    uint32_t wordsWithLetter[NUM_ALPHABET] = { 0 };
+    for (uint32_t i = 0; i < bank.wordCount; i++) {
+        LetterState letters;
+        startLetterState(&letters, bank.words[i]);
+        for (int j = 0; j < NUM_ALPHABET; j++) {
+            if (letters.answerLetters & ((LetterMask)1 << j)) wordsWithLetter[j]++;
+        }
+    }
+    for (int i = 0; i < NUM_ALPHABET; i++) {
+        job.letterRarity[i] = -log2((wordsWithLetter[i] + 1.0) / (bank.wordCount + 1.0));
+    }
+
+    LARGE_INTEGER frequency, startTime, endTime;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&startTime);
+
+    job.nextWord = -1;
+    threadCount = runWorkers(runTierWorker, &job, threadCount, bank.wordCount);
+
+    // a worker that couldn't allocate its buffers doesn't score anything, so make sure no word was left with a garbage score
+    if ((uint32_t)job.scoredCount < bank.wordCount) {
+        fprintf(stderr, "Only %ld of the %u words could be scored\n", (long)job.scoredCount, bank.wordCount);
+        free(job.scores);
+        freeShapeGroups(&job.solver);
+        freeWordBank(&bank);
+        return 0;
+    }
+    qsort(job.scores, bank.wordCount, sizeof(WordScore), compareWordScores);
+
+    QueryPerformanceCounter(&endTime);
+    double seconds = (double)(endTime.QuadPart - startTime.QuadPart) / frequency.QuadPart;
+
+    // writing the words out tier by tier, each after the line that starts its tier
+    const char* tierLines[NUM_TIERS] = { "[EASY]", "[MEDIUM]", "[HARD]", "[EXPERT]" };
+    int succeeded = 1;
+    FILE* output = fopen(wordFile, "w");
+    if (output == NULL) {
+        fprintf(stderr, "An error occurred trying to write %s\n", wordFile);
+        succeeded = 0;
+    }
+    else {
+        printf("Tiered %u words from %s in %.3f s using %d threads\n\n", bank.wordCount, wordList, seconds, threadCount);
+        printf("%-10s %8s %12s %12s %12s\n", "Tier", "Words", "Avg letters", "Avg wrong", "Avg score");
+
+        for (int i = 0; i < NUM_TIERS; i++) {
+            uint32_t tierStart = (uint32_t)((uint64_t)bank.wordCount * i / NUM_TIERS);
+            uint32_t tierEnd = (uint32_t)((uint64_t)bank.wordCount * (i + 1) / NUM_TIERS);
+            double letters = 0, wrongGuesses = 0, score = 0;
+
+            fprintf(output, "%s\n", tierLines[i]);
+            for (uint32_t j = tierStart; j < tierEnd; j++) {
+                fprintf(output, "%s\n", bank.words[job.scores[j].wordNumber]);
+                letters += job.scores[j].letterCount;
+                wrongGuesses += job.scores[j].wrongGuesses;
+                score += job.scores[j].score;
+            }
+
+            uint32_t count = tierEnd - tierStart;
+            printf("%-10s %8u %12.2f %12.2f %12.2f\n", tierLines[i], count, count > 0 ? letters / count : 0.0,
+                count > 0 ? wrongGuesses / count : 0.0, count > 0 ? score / count : 0.0);
+        }
+        if (fclose(output) != 0) {
+            fprintf(stderr, "An error occurred trying to write %s\n", wordFile);
+            succeeded = 0;
+        }
+    }
+
+    // indexing the new word bank now, so the first game doesn't have to
+    if (succeeded) {
+        WordIndex index;
+        succeeded = openWordIndex(&index, wordFile, indexFile);
+        if (succeeded) closeWordIndex(&index);
+    }
+
+    free(job.scores);
+    freeShapeGroups(&job.solver);
+    freeWordBank(&bank);
+    return succeeded;
+}
+
+// reads every non-empty line of a word list into a word bank (all in the first tier), skipping any tier lines
+int loadWordList(WordBank* bank, const char* fileName) {
+    memset(bank, 0, sizeof(WordBank));
+
+    FILE* wordList = fopen(fileName, "rb");
+    if (wordList == NULL) {
+        fprintf(stderr, "An error occurred trying to open %s\n", fileName);
+        return 0;
+    }
+    long fileSize = -1;
+    if (fseek(wordList, 0, SEEK_END) == 0) {
+        fileSize = ftell(wordList);
+        fseek(wordList, 0, SEEK_SET);
+    }
+    if (fileSize < 0) {
+        fprintf(stderr, "An error occurred trying to read %s\n", fileName);
+        fclose(wordList);
+        return 0;
+    }
+
+    // the list is read whole, and each line end is turned into the '\0' that ends its word
+    bank->text = malloc(fileSize + 1);
+    if (bank->text == NULL) {
+        fprintf(stderr, "Memory allocation failed!\n");
+        fclose(wordList);
+        return 0;
+    }
+    size_t bytesRead = fread(bank->text, 1, fileSize, wordList);
+    fclose(wordList);
+    bank->text[bytesRead] = '\n';
+
+    uint32_t lineCount = 0;
+    for (size_t i = 0; i <= bytesRead; i++) {
+        if (bank->text[i] == '\n') lineCount++;
+    }
+    bank->words = malloc(lineCount * sizeof(char*));
+    bank->wordLengths = malloc(lineCount * sizeof(uint32_t));
+    if (bank->words == NULL || bank->wordLengths == NULL) {
+        fprintf(stderr, "Memory allocation failed!\n");
+        freeWordBank(bank);
+        return 0;
+    }
+
+    char* lineStart = bank->text;
+    for (size_t i = 0; i <= bytesRead; i++) {
+        if (bank->text[i] != '\n') {
+            continue;
+        }
+        uint32_t length = (uint32_t)(bank->text + i - lineStart);
+        if (length > 0 && lineStart[length - 1] == '\r') {
+            length--;
+        }
+        lineStart[length] = '\0';
+
+        if (length > 0 && findWordTier(lineStart, length) < 0) {
+            bank->words[bank->wordCount] = lineStart;
+            bank->wordLengths[bank->wordCount] = length;
+            bank->wordCount++;
+        }
+        lineStart = bank->text + i + 1;
+    }
+    bank->tierCounts[0] = bank->wordCount;
+    return 1;
+}
+
+VOID CALLBACK runTierWorker(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work) {
+    scoreWords(context);
+}
+
+void scoreWords(TierJob* job) {
+    const WordBank* bank = job->solver.bank;
+
+    uint32_t* candidates = malloc(job->solver.largestGroup * sizeof(uint32_t));
+    uint64_t* keys = malloc((size_t)NUM_ALPHABET * job->solver.largestGroup * sizeof(uint64_t));
+    if (candidates == NULL || keys == NULL) {
+        fprintf(stderr, "Memory allocation failed!\n");
+        free(candidates);
+        free(keys);
+        return;
+    }
+
+    // keep claiming the next word in the list until every word has been scored, counting them to add to the total once at the end
+    LONG wordNumber;
+    LONG scoredCount = 0;
+    while ((wordNumber = InterlockedIncrement(&job->nextWord)) < (LONG)bank->wordCount) {
+        const char* word = bank->words[wordNumber];
+        WordScore* score = &job->scores[wordNumber];
+
+        LetterState letters;
+        startLetterState(&letters, word);
+        double rarity = 0;
+        for (int i = 0; i < NUM_ALPHABET; i++) {
+            if (letters.answerLetters & ((LetterMask)1 << i)) rarity += job->letterRarity[i];
+        }
+        uint32_t letterCount = 0;
+        for (const char* c = word; *c != '\0'; c++) {
+            if (letterBit(*c) != 0) letterCount++;
+        }
+
+        // expert difficulty has no lifelines, so the solver's guesses measure the word itself
+        HangmanGame game;
+        newGame(&game, word, NUM_TIERS);
+        int turns = playSolverGame(&job->solver, &game, candidates, keys);
+
+        score->wordNumber = (uint32_t)wordNumber;
+        score->letterCount = letterCount;
+        score->wrongGuesses = game.numGuesses;
+        score->score = TIER_SOLVER_WEIGHT * game.numGuesses + TIER_TURN_WEIGHT * turns + TIER_LENGTH_WEIGHT * letterCount + rarity;
+        scoredCount++;
+    }
+
+    InterlockedExchangeAdd(&job->scoredCount, scoredCount);
+    free(candidates);
+    free(keys);
+}
+
+// easiest first, keeping the list's order for words with the same score
+int compareWordScores(const void* a, const void* b) {
+    const WordScore* first = a;
+    const WordScore* second = b;
+    if (first->score != second->score) return first->score < second->score ? -1 : 1;
+    return (first->wordNumber > second->wordNumber) - (first->wordNumber < second->wordNumber);
+}
@@ -26,14 +26,59 @@
 #include <time.h>
 #include <windows.h>
 #include <stdbool.h>
-
-#define GRID_SIZE 23
-#define NUM_SQUARES (GRID_SIZE - 3) * (GRID_SIZE - 3)
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#define GRID_SIZE 23 // dimensions of level files that don't start with a size header
+#define MIN_BOARD_SIZE 4 // smallest width or height a level file's header may ask for, which leaves the enemies somewhere to roam
+#define MAX_BOARD_SIZE 1024 // largest width or height a level file's header may ask for
+
+/* levels exported by parseImage --pack are stored as binary records in the pack file instead of being
+    written out and re-parsed as text. the record layout must match the one written by parseImage.c. */
+#define LEVEL_PACK_FILE "levels.pack"
+#define LEVEL_RECORD_MAGIC "LVLR"
+#define LEVEL_NAME_SIZE 32 // bytes of each record's level name, padded with nulls
 #define FPS 10
 #define FRAME_DELAY 1000 / FPS // in milliseconds
 
 #define AGGRO_RADIUS 6
 
+// hierarchical pathfinding: the board is split into clusters, and searches run over the portals between them
+#define CLUSTER_SIZE 8 // width and height (in cells) of each cluster
+#define MAX_CLUSTER_PORTALS (2 * CLUSTER_SIZE) // at most CLUSTER_SIZE / 2 entrances fit along each of the 4 borders
+#define MAX_ENTRANCE_WIDTH 6 // entrances wider than this get a portal at both ends instead of one in the middle
+#define HIERARCHICAL_MIN_SIZE 48 // boards at least this wide use the cluster graph instead of searching the full grid
+
+// the next-hop table grows with the square of the open cells, so boards with more open cells than this keep searching
+#define NEXT_HOP_MAX_CELLS 2048
+
+// steps the distance map around the player spreads out to, which covers every enemy close enough to have seen the player
+#define PLAYER_DISTANCE_LIMIT 32
+
+// enemy path requests are searched a slice at a time so that a frame never expands more than PATH_BUDGET_PER_FRAME nodes
+#define PATH_BUDGET_PER_FRAME 4096
+#define PATH_SLICE 256 // nodes expanded by one search before the next search in line gets its turn
+#define MAX_ACTIVE_SEARCHES 4 // requests beyond this wait in the queue until a search slot frees up
+
+#define WHEEL_SLOTS 64 // frames covered by one turn of the enemy timer wheel (a power of 2 so the slot is just a mask)
+
+#define MAX_PLANNING_THREADS 8 // most threads the enemy planning phase is split across
+#define SIGHT_BATCH 32 // line of sight checks handed to a worker at once, run through the batched kernel together
+#define MIN_PARALLEL_SIGHT_BATCHES 2 // fewer batches than this are quicker to run than to hand out to the thread pool
+#define GATHER_PADDING 3 // spare bytes after each layer's last cell, so a 4 byte load starting at any cell stays inside the block
+
+/* boards are sized at load time from the header of their level file. building with FIXED_GRID_SIZE defined
+    only accepts GRID_SIZE x GRID_SIZE levels, which turns the board dimensions used by the hot movement
+    and pathfinding checks into compile-time constants. */
+#ifdef FIXED_GRID_SIZE
+#define BOARD_WIDTH(grid) GRID_SIZE
+#define BOARD_HEIGHT(grid) GRID_SIZE
+#else
+#define BOARD_WIDTH(grid) ((grid).width)
+#define BOARD_HEIGHT(grid) ((grid).height)
+#endif
+
 // defining all the colors to be used
 #define RED FOREGROUND_RED
 #define GREEN FOREGROUND_GREEN
@@ -68,7 +113,11 @@ typedef enum {
     MALLOC_ALL_ENEMIES_FAILED,
     MALLOC_ALL_ITEMS_FAILED,
     MALLOC_ITEM_COUNT_FAILED,
-    REALLOC_ITEM_COUNT_FAILED
+    REALLOC_ITEM_COUNT_FAILED,
+    MALLOC_NAVIGATION_MAP_FAILED,
+    INVALID_LEVEL_SIZE,
+    MALLOC_ENEMY_SCHEDULER_FAILED,
+    INVALID_LEVEL_RECORD
 } ErrorCode;
 
 typedef enum {
@@ -84,6 +133,12 @@ typedef enum {
     NUM_ENEMY_TYPES // this variable automatically counts the number of enemy types
 } EnemyType;
 
+// the search each enemy type uses to find its way to the player's LSP or its next roaming location
+typedef enum {
+    ASTAR_SEARCH, // cell-by-cell A* search (hierarchical on large boards)
+    JUMP_POINT_SEARCH // A* over jump points only, which skips the many equally short paths on open uniform-cost grids
+} SearchType;
+
 typedef enum {
     OBJ_ITEM,
     BATTERIES_ITEM,
@@ -103,11 +158,22 @@ struct Position {
 typedef struct Position Position;
 
 struct Enemy {
-    Position roamArr[NUM_SQUARES];
     Position pos;
     Position playerLSP; // LSP = last seen position
-    int roamIndex;
+    int roamIndex; // how many of the board's roam positions the enemy has tried since it last picked a roam order
+    int roamStart; // the enemy's own order thru the board's roam positions: the first one it tries, then how far along
+    int roamStride; // it steps each time (never sharing a factor with the count, so every position comes up once per order)
     int moveInterval;
+    SearchType searchType;
+
+    // the last path found, followed one step per move until the target moves or the walls change
+    Position* cachedPath;
+    int cachedPathLength;
+    int cachedPathCapacity;
+    int cachedPathIndex; // index of the enemy's current position along the cached path
+    Position cachedTarget;
+    unsigned int cachedWallVersion;
+
     int specialAbility;
     char passiveMarker;
     char aggroMarker;
@@ -162,7 +228,119 @@ struct PriorityQueue { // will be implemented as a heap
 };
 typedef struct PriorityQueue PriorityQueue;
 
+struct Portal { // a walkable cell on a cluster's border that connects to the neighboring cluster
+    Position pos;
+    unsigned char exits; // bitmask of the directions (indices of dx/dy) that cross into a neighboring cluster
+};
+typedef struct Portal Portal;
+
+struct Cluster {
+    Position origin; // top-left cell of the cluster
+    int width, height; // clusters along the right and bottom edges of the board may be smaller than CLUSTER_SIZE
+    Portal portals[MAX_CLUSTER_PORTALS];
+    int portalCount;
+    short portalDistances[MAX_CLUSTER_PORTALS][MAX_CLUSTER_PORTALS]; // walking distance between each pair of portals (-1 if unreachable)
+    bool isDirty; // set whenever a wall in or beside the cluster changes, so its portals are rebuilt before the next search
+};
+typedef struct Cluster Cluster;
+
+typedef enum {
+    SEARCH_RUNNING,
+    SEARCH_FOUND,
+    SEARCH_FAILED
+} SearchStatus;
+
+struct PathSearch { // the state of a search that can be paused at the end of a frame and resumed on the next one
+    int* gCosts; // all indexed by y * width + x (or by portal node for the cluster graph), allocated the first time the slot is used
+    int* parents;
+    unsigned int* stamps; // a cell is open this search if its stamp is 2 * currentStamp, and closed if it's 2 * currentStamp + 1
+    unsigned int currentStamp;
+    long long* heap;
+    int heapSize;
+    int heapCapacity;
+    bool inUse;
+
+    // walking distances from the start and goal to each cell of their own clusters, for searches over the cluster graph
+    int startDistances[CLUSTER_SIZE * CLUSTER_SIZE];
+    int goalDistances[CLUSTER_SIZE * CLUSTER_SIZE];
+};
+typedef struct PathSearch PathSearch;
+
+struct PathRequest {
+    Enemy* enemy;
+    PathSearch* search; // NULL while the request is still waiting for a search slot
+    Position start, end; // only set once the search starts, so a waiting request always searches from the enemy's latest position
+    SearchType searchType;
+    unsigned int wallVersion;
+
+    // this round's slice of the frame's budget, then what the search did with it
+    int sliceBudget;
+    int expansions;
+    SearchStatus status;
+};
+typedef struct PathRequest PathRequest;
+
+struct Bitboard { // one bit per cell, with each row stored as wordsPerRow words (cell x is bit x % 64 of word x / 64)
+    uint64_t* words;
+    int wordsPerRow;
+    int height;
+};
+typedef struct Bitboard Bitboard;
+
+struct NavigationMap {
+    int cellCount;
+
+    // scratch buffers for a full A* search, sized to the board when the level is loaded
+    bool* closedSet;
+    Node** allNodes;
+    Position* path;
+    unsigned int wallVersion; // incremented whenever a wall is destroyed so that cached enemy paths know to re-plan
+
+    // queue of enemy path requests, oldest first. the first MAX_ACTIVE_SEARCHES of them are the ones being searched
+    PathRequest* requests;
+    int requestCount;
+    int requestCapacity;
+    PathSearch searches[MAX_ACTIVE_SEARCHES];
+    int frameBudget; // nodes that can still be expanded (or cells scanned) this frame, negative if the last frame went over
+
+    /* on levels that can never lose a wall, the first step of the shortest path from every open cell to every other,
+        packed 2 bits (an index into dx/dy) per pair as nextHops[to * openCount + from]. NULL on every other level,
+        and freed as soon as a wall is destroyed, after which enemies go back to searching. */
+    unsigned char* nextHops;
+    int* openCells; // each cell's number among the open cells, or -1 for walls (indexed by y * width + x)
+    int* openAreas; // which connected area each open cell is in, since the 2 bits can't also say a cell is unreachable
+    int openCount;
+
+    /* bitboards for flood filling the board a whole ring at a time. open has a bit for every cell that isn't a wall
+        (kept up to date as walls are destroyed), and frontier and nextRing are scratch for the ring being grown. */
+    Bitboard open;
+    Bitboard frontier, nextRing;
+    Bitboard area; // every cell reachable from the last roaming enemy's position, as of areaWallVersion
+    bool hasArea;
+    unsigned int areaWallVersion;
+
+    // every cell within PLAYER_DISTANCE_LIMIT steps of distancesFrom, and how many steps (only set for cells in nearPlayer)
+    Bitboard nearPlayer;
+    int* playerDistances;
+    Position distancesFrom;
+    unsigned int distancesWallVersion;
+    bool hasDistances;
+
+    // the cluster graph is only built for boards at least HIERARCHICAL_MIN_SIZE wide (clusters is NULL otherwise)
+    Cluster* clusters;
+    int clustersWide, clustersHigh;
+    bool hasDirtyClusters;
+
+    /* the abstract graph is searched in the request's own search slot. each portal slot of each cluster is a node,
+        plus two extra nodes at the end for the start and goal positions of the search. */
+    int nodeCount;
+    int* route; // scratch for the abstract route while it's refined into steps
+};
+typedef struct NavigationMap NavigationMap;
+
 struct Level {
+    int width, height;
+
     Position start;
     Position end;
 
@@ -181,6 +359,18 @@ struct Level {
 };
 typedef struct Level Level;
 
+typedef void (*ParallelTask)(void* context, int item);
+
+struct WorkerPool { // hands out the items of one parallel job at a time to the Windows thread pool
+    PTP_WORK work;
+    int workerCount; // threads working on each job, counting the one that started it
+    ParallelTask task;
+    void* context;
+    int itemCount;
+    volatile LONG nextItem; // workers claim items by incrementing this, so how items are split between threads never changes the result
+};
+typedef struct WorkerPool WorkerPool;
+
 struct AllEntities {
     /* the game board is composed of 3 layers, each layer storing all locations of that entity type:
         - the player layer (player and enemies)
@@ -193,52 +383,154 @@ struct AllEntities {
             to be called after to ensure that the item can still be seen on the grid immediately after. by keeping each type of entity
             in its own layer, such functions would not be necessary. */
 
+    /* each layer's cells are stored in one contiguous block of width * height chars, with the row pointers
+        pointing into it so that every layer can still be indexed as layer[y][x]. */
+
     unsigned char** playerLayer;
     unsigned char** wallLayer;
     unsigned char** itemLayer;
+    int width, height;
+
+    Position* roamArr; // every position an enemy can roam to, shuffled once and shared by all the enemies on the board
+    int roamCount;
+
+    NavigationMap* navMap; // pathfinding scratch buffers, plus the cluster graph for large boards
+    WorkerPool* workers; // NULL if the thread pool couldn't be set up, in which case the planning phase runs on one thread
 };
 typedef struct AllEntities AllEntities;
 
+struct WakeEntry { // an enemy due to be touched on wakeFrame
+    unsigned int wakeFrame;
+    int type;
+    int index;
+};
+typedef struct WakeEntry WakeEntry;
+
+struct WheelSlot {
+    WakeEntry* entries;
+    int count;
+    int capacity;
+};
+typedef struct WheelSlot WheelSlot;
+
+/* a timer wheel of enemy wakeups. an enemy waking on frame f sits in slot f % WHEEL_SLOTS, along with any enemies
+    waking whole turns of the wheel later, so each frame only looks at the enemies that might act on it. */
+struct EnemyScheduler {
+    WheelSlot slots[WHEEL_SLOTS];
+    WakeEntry* due; // scratch for the enemies waking on the current frame, sized to every enemy in the level
+    bool* seesPlayer; // each due enemy's line of sight of the player, worked out in the planning phase
+    int* sightX; // positions and sight radii of the due enemies that look for the player, kept as separate arrays for the batched kernel
+    int* sightY;
+    int* sightRange;
+    int* sightItems; // where each of those enemies sits in the due list
+    int sightCount;
+};
+typedef struct EnemyScheduler EnemyScheduler;
+
 struct GameBoard {
     AllEntities grid;
     Position** allItems;
     Enemy** allEnemies;
+    EnemyScheduler* scheduler;
     Player player;
     ErrorCode hasError;
 };
 typedef struct GameBoard GameBoard;
 
+struct EnemyFrame { // everything the enemy update kernels share for one frame, including the type-wide values computed once per frame
+    int frameCounter;
+    AllEntities* grid;
+    Enemy** allEnemies;
+    EnemyScheduler* scheduler;
+    Player player;
+    Particle** bombHead;
+    Bullet** bulletHead;
+    int trapperInterval;
+    int bombSpawnChance;
+    int burstInterval;
+};
+typedef struct EnemyFrame EnemyFrame;
+
+struct EnemyMove { // what an enemy's update kernel decided to do on its move
+    Position newPos;
+    bool LSPflag; // follow the path to the player's LSP, or make a random move if there isn't one
+    bool isBullet;
+    bool seesPlayer; // whether the enemy has line of sight of the player (only checked for types with a sight radius)
+    int wakeDelay; // frames until the enemy next needs to be touched, or 0 if it never does
+};
+typedef struct EnemyMove EnemyMove;
+
+typedef void (*EnemyKernel)(EnemyFrame* frame, Enemy* enemy, EnemyMove* move);
+
 bool isValid(AllEntities grid, Position entity, char ID);
 bool canMove(Position pos, AllEntities grid);
 bool doesDetect(Position detector, Position detectee, int detectionRadius);
 Particle* addNewParticle(Particle* head, Position pos, char marker, int frameTimer);
-void moveAllEnemies(int frameCounter, Level level, AllEntities* grid, Enemy** enemy, Player player, Particle** bombHead, Bullet** head);
+void moveAllEnemies(int frameCounter, AllEntities* grid, Enemy** enemy, EnemyScheduler* scheduler, Player player, Particle** bombHead, Bullet** head);
+EnemyScheduler* createEnemyScheduler(Level level, Enemy** allEnemies);
+void freeEnemyScheduler(EnemyScheduler* scheduler);
+bool scheduleEnemy(EnemyScheduler* scheduler, int type, int index, unsigned int wakeFrame);
+int compareWakeEntries(const void* a, const void* b);
+int skipCountdown(Enemy* enemy, int wakeValue);
+WorkerPool* createWorkerPool(void);
+void freeWorkerPool(WorkerPool* pool);
+void runParallel(WorkerPool* pool, ParallelTask task, void* context, int itemCount, int minParallelItems);
+VOID CALLBACK runWorker(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work);
+void claimWorkerItems(WorkerPool* pool);
+void planEnemySight(void* context, int batch);
+void hasLineOfSightBatch(const int* xs, const int* ys, const int* ranges, int count, Position player, AllEntities* grid, bool* results);
 void setBomb(Particle** head, Position pos, unsigned char** itemLayer, int spawnChance);
+void updateBasicEnemy(EnemyFrame* frame, Enemy* enemy, EnemyMove* move);
+void updatePatrolEnemy(EnemyFrame* frame, Enemy* enemy, EnemyMove* move);
+void updateTeleportEnemy(EnemyFrame* frame, Enemy* enemy, EnemyMove* move);
+void updateChaserEnemy(EnemyFrame* frame, Enemy* enemy, EnemyMove* move);
+void updateTrapperEnemy(EnemyFrame* frame, Enemy* enemy, EnemyMove* move);
+void updateBurstEnemy(EnemyFrame* frame, Enemy* enemy, EnemyMove* move);
+void updateShooterEnemy(EnemyFrame* frame, Enemy* enemy, EnemyMove* move);
+void updateIdleEnemy(EnemyFrame* frame, Enemy* enemy, EnemyMove* move);
+void finishEnemyMove(EnemyFrame* frame, Enemy* enemy, EnemyMove* move);
 void roamToUnvisited(Enemy* enemy, AllEntities grid);
-void updateAllParticles(Particle** bombHead, Particle** explosionHead, unsigned char** itemLayer, unsigned char** wallLayer, int frameCounter);
+void updateAllParticles(Particle** bombHead, Particle** explosionHead, AllEntities* grid, int frameCounter);
 bool movePlayer(Level level, AllEntities* grid, Player* player, char movement);
 bool gameLoop(Level* level, GameBoard* grid);
-void initializeRoamArr(Position* roamArr);
+int initializeRoamArr(Position* roamArr, int width, int height);
 void updateBullets(Bullet** head, Particle** bulletParticles, AllEntities* grid);
 void displayBombFlicker(Particle* head, unsigned char** itemLayer, int frameCounter);
 int findBulletDirection(Position old, Position new);
 void freeBombs(Particle* bombHead, Particle* explosionHead);
-void updateAllParticles(Particle** bombHead, Particle** explosionHead, unsigned char** itemLayer, unsigned char** wallLayer, int frameCounter);
-void updateParticleType(Particle** typeHead, Particle** explosionHead, unsigned char** itemLayer, unsigned char** wallLayer, int frameCounter);
-unsigned char** initializeGrid(void);
+void updateParticleType(Particle** typeHead, Particle** explosionHead, AllEntities* grid, int frameCounter);
+void clearWall(AllEntities* grid, Position pos);
+unsigned char** initializeGrid(int width, int height);
+void freeGrid(unsigned char** grid);
 GameBoard initializeGameBoard(Level level, bool isLevel);
 Player initializePlayer(Level level);
-Enemy initializeEnemy(unsigned char** playerLayer, Position newPos, char passiveMarker, char aggroMarker, int moveInterval);
+Enemy initializeEnemy(unsigned char** playerLayer, Position newPos, char passiveMarker, char aggroMarker, int moveInterval, SearchType searchType, int roamCount);
 bool matchesPosition(Position a, Position b);
 bool gameWin(Level level, Position pos);
 bool gameLose(Level level, GameBoard game, Particle* explosionHead);
 void setCursorPosition(int x, int y);
 Bullet* shootBullet(Bullet* head, Position bulletPos, int direction);
 void makeRandomMove(AllEntities grid, Position* newPos, Position oldPos);
-Enemy** initializeAllEnemies(Level level, unsigned char** playerLayer);
+Enemy** initializeAllEnemies(Level level, unsigned char** playerLayer, int roamCount);
+void freeAllEnemies(Level level, Enemy** allEnemies);
+void freeGameBoard(Level level, GameBoard* gameElements);
 Position** initializeAllItems(Level level, unsigned char** itemLayer);
-Level initializeLevel(void);
+Level initializeLevel(int width, int height);
+bool readLevelHeader(FILE* levelFile, int* width, int* height);
+bool allocateLevelArrays(Level* newLevel);
+void finishLevelArrays(Level* newLevel);
+Level loadLevel(const char* fileName);
+long findLevelRecord(FILE* packFile, const char* levelName);
+Level readLevelRecord(FILE* packFile);
+bool isOnBoard(Position pos, int width, int height);
+bool readRecordInts(FILE* packFile, int32_t* values, int count);
 void shuffleArr(Position* roamArr, int size);
+void pickRoamOrder(Enemy* enemy, int roamCount);
+void cachePath(Enemy* enemy, Position* path, int pathLength, unsigned int wallVersion);
+bool isCachedPathCurrent(Enemy* enemy, AllEntities grid);
+bool followCachedPath(Enemy* enemy, AllEntities grid, Position* newPos);
+bool followNextHop(Enemy* enemy, AllEntities grid, Position* newPos);
+bool stepTowardPlayer(Enemy* enemy, AllEntities grid, Position player, Position* newPos);
 Node* findNode(PriorityQueue* openSet, Position pos);
 
 // all function prototypes for the A* search algorithm implemented for the enemys' pathfinding of the player
@@ -252,6 +544,52 @@ void heapifyDown(PriorityQueue* pq, int index);
 void finalizePath(Node* endNode, Position* path, int* pathLength);
 int calculateHCost(Position a, Position b);
 bool findPath(AllEntities grid, Position start, Position end, Position* path, int* pathLength);
+Position jumpFrom(AllEntities grid, Position pos, int xStep, int yStep, Position end, int* scanned);
+int benchmarkPathfinding(void);
+int benchmarkEnemyPlanning(void);
+
+// all function prototypes for the hierarchical pathfinder used on large boards
+NavigationMap* createNavigationMap(int width, int height);
+void freeNavigationMap(NavigationMap* navMap);
+bool isOpenCell(AllEntities grid, Position pos);
+int findCluster(NavigationMap* navMap, Position pos);
+void markClusterDirty(NavigationMap* navMap, Position pos);
+void rebuildCluster(AllEntities grid, Cluster* cluster);
+void addBorderPortals(AllEntities grid, Cluster* cluster, int direction);
+int searchCluster(AllEntities grid, Cluster* cluster, Position start, int* distances, int* previous);
+int findPortal(Cluster* cluster, Position pos);
+bool buildNextHopTable(AllEntities grid);
+void freeNextHopTable(NavigationMap* navMap);
+bool findNextHop(AllEntities grid, Position from, Position to, Position* next);
+bool createBitboard(Bitboard* board, int width, int height);
+void freeBitboard(Bitboard* board);
+bool testBit(const Bitboard* board, Position pos);
+void setBit(Bitboard* board, Position pos);
+int lowestSetBit(uint64_t bits);
+void fillOpenBitboard(AllEntities grid);
+int floodFill(NavigationMap* navMap, Position start, int maxDistance, Bitboard* reached, int* distances, int width);
+void findReachableArea(AllEntities grid, Position start);
+int findPlayerDistance(AllEntities grid, Position player, Position pos);
+bool pushHeapEntry(long long** heap, int* heapSize, int* heapCapacity, int node, int fCost);
+long long popHeapEntry(long long* heap, int* heapSize);
+bool relaxPortalNode(PathSearch* search, int node, int parent, int gCost, Position nodePos, Position end);
+bool appendClusterPath(AllEntities grid, Cluster* cluster, Position from, Position to, Position* path, int* pathLength, int maxLength);
+bool rebuildDirtyClusters(AllEntities grid);
+bool startHierarchicalSearch(AllEntities grid, PathRequest* request);
+SearchStatus stepHierarchicalSearch(AllEntities grid, PathRequest* request, int* expansions);
+bool buildHierarchicalPath(AllEntities grid, PathRequest* request, Position* path, int* pathLength, int maxLength);
+
+// all function prototypes for the time-sliced enemy path requests
+bool requestEnemyPath(NavigationMap* navMap, Enemy* enemy);
+void servicePathRequests(AllEntities grid);
+bool startPathSearch(AllEntities grid, PathRequest* request);
+bool pushSearchCell(AllEntities grid, PathSearch* search, int cell, int parent, int gCost, Position end);
+SearchStatus stepPathSearch(AllEntities grid, PathRequest* request, int* expansions);
+void stepPathSearchTask(void* context, int item);
+bool isHierarchicalRequest(NavigationMap* navMap, PathRequest* request);
+bool buildSearchPath(AllEntities grid, PathRequest* request, Position* path, int* pathLength);
+void finishPathRequest(AllEntities grid, int index, SearchStatus status, int pathLength);
+bool runPathRequest(AllEntities grid, SearchType searchType, Position start, Position end, Position* path, int* pathLength);
 
 // all text files that will be used to load the levels
 const char* allLevelFiles[] = {
@@ -321,7 +659,6 @@ const char* gameOverMenu[] = {
     "Return to Main Menu"
 };
 
-const Position postlevelCursor = { 0, GRID_SIZE + 5 };
 const Position mainMenuCursor = { 0, 2 };
 const Position INVALID_POS = { -1, -1 };
 
@@ -341,6 +678,20 @@ const char harmfulItemMarkers[];
 // defining the movement interval of each enemy type
 const int moveIntervals[NUM_ENEMY_TYPES] = { 10, 10, 1, 1, 1, 1, 10, 10, 1 };
 
+// defining the update kernel of each enemy type (the mimic and wall breaker don't have behaviors yet)
+const EnemyKernel enemyKernels[NUM_ENEMY_TYPES] = {
+    updateBasicEnemy, updatePatrolEnemy, updateTeleportEnemy, updateChaserEnemy, updateTrapperEnemy,
+    updateBurstEnemy, updateIdleEnemy, updateIdleEnemy, updateShooterEnemy
+};
+
+// defining how far each enemy type looks for the player every frame (0 for the types that don't)
+const int sightRadii[NUM_ENEMY_TYPES] = { 0, 0, 0, AGGRO_RADIUS, 0, 0, 0, 0, AGGRO_RADIUS * 2 };
+
+// defining the pathfinding search of each enemy type: the types that chase the player across the board use jump point search
+const SearchType enemySearchTypes[NUM_ENEMY_TYPES] = {
+    ASTAR_SEARCH, ASTAR_SEARCH, ASTAR_SEARCH, JUMP_POINT_SEARCH, ASTAR_SEARCH, JUMP_POINT_SEARCH, ASTAR_SEARCH, ASTAR_SEARCH, JUMP_POINT_SEARCH
+};
+
 int calculateHCost(Position a, Position b) {
 
     // calculate the Manhattan distance from the finishing point
@@ -493,12 +844,13 @@ void finalizePath(Node* endNode, Position* path, int* pathLength) {
 bool findPath(AllEntities grid, Position start, Position end, Position* path, int* pathLength) {
     bool pathFound = false;
 
-    // openSet stores the nodes to explore, closedSet stores the nodes already explored
+    // openSet stores the nodes to explore, closedSet stores the nodes already explored (both indexed by y * width + x)
     PriorityQueue* openSet = createPriorityQueue(128);
-    bool closedSet[GRID_SIZE][GRID_SIZE] = { false };
+    bool* closedSet = grid.navMap->closedSet;
+    memset(closedSet, false, sizeof(bool) * grid.navMap->cellCount);
 
     // track all nodes created to free them later
-    Node** allNodes = malloc(sizeof(Node*) * (GRID_SIZE * GRID_SIZE));
+    Node** allNodes = grid.navMap->allNodes;
     int nodeCount = 0;
 
     // initialize the heap by creating the root node for it
@@ -511,7 +863,7 @@ bool findPath(AllEntities grid, Position start, Position end, Position* path, in
 
         // evaluate the root node of the pq and mark it as visited on the closedSet
         Node* currentNode = pop(openSet);
-        closedSet[currentNode->pos.y][currentNode->pos.x] = true;
+        closedSet[currentNode->pos.y * BOARD_WIDTH(grid) + currentNode->pos.x] = true;
 
         // return true if the destination is reached
         if (matchesPosition(currentNode->pos, end)) {
@@ -527,7 +879,7 @@ bool findPath(AllEntities grid, Position start, Position end, Position* path, in
             newPos.y = currentNode->pos.y + dy[i];
 
             // if the neighboring node is valid and not already in the closedSet, then push it to the openSet to be evaluated
-            if (!closedSet[newPos.y][newPos.x] && isValid(grid, newPos, 'e')) {
+            if (isValid(grid, newPos, 'e') && !closedSet[newPos.y * BOARD_WIDTH(grid) + newPos.x]) {
                 int newGCost = currentNode->gCost + 1;
                 int newHCost = calculateHCost(newPos, end);
 
@@ -535,11 +887,17 @@ bool findPath(AllEntities grid, Position start, Position end, Position* path, in
                 Node* existingNode = findNode(openSet, newPos);
                 if (existingNode != NULL) {
 
-                    // if the new path is shorter, update the node
-                    if (newGCost < existingNode->hCost) {
+                    // if the new path is shorter, update the node and move it up the heap to its new position
+                    if (newGCost < existingNode->gCost) {
                         existingNode->gCost = newGCost;
                         existingNode->fCost = newGCost + newHCost;
                         existingNode->parent = currentNode;
+                        for (int j = 0; j < openSet->size; j++) {
+                            if (openSet->nodes[j] == existingNode) {
+                                heapifyUp(openSet, j);
+                                break;
+                            }
+                        }
                     }
                 }
                 else { // if the node is not in the openSet, add it                    
@@ -555,7 +913,6 @@ bool findPath(AllEntities grid, Position start, Position end, Position* path, in
     for (int i = 0; i < nodeCount; i++) {
         free(allNodes[i]);
     }
-    free(allNodes);
 
     // free the priority queue
     free(openSet->nodes);
@@ -576,237 +933,1407 @@ Node* findNode(PriorityQueue* openSet, Position pos) {
     return NULL; // return NULL if not found
 }
 
-void drawGameState(AllEntities grid, Level level) {
-    HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE); // used to change the color of text
-    setCursorPosition(0, 2); // reset the cursor to the start of the third line to overwrite the grid
+Position jumpFrom(AllEntities grid, Position pos, int xStep, int yStep, Position end, int* scanned) {
 
-    for (int y = 0; y < GRID_SIZE; y++) {
-        for (int x = 0; x < GRID_SIZE; x++) {
+    /* keep stepping in one direction until a jump point is found: the goal, or a cell where a path around a wall
+        opens up (a "forced" neighbor). every cell skipped along the way can be reached just as cheaply without
+        being expanded, which is what lets JPS prune the symmetric paths that A* would otherwise explore.
+        every cell stepped onto (including by the horizontal scans of a vertical jump) is added to scanned. */
+    while (true) {
+        pos.x += xStep;
+        pos.y += yStep;
+        (*scanned)++;
 
-            // order of precedence: beings are printed on top, then items, then the walls
-            if (grid.playerLayer[y][x] != ' ') {
+        if (!isValid(grid, pos, 'e')) {
+            return INVALID_POS;
+        }
+        if (matchesPosition(pos, end)) {
+            return pos;
+        }
 
-                // mark the player with a red color
-                if (grid.playerLayer[y][x] == 'X') {
-                    SetConsoleTextAttribute(hConsole, LIGHT_GREEN);
-                    putchar(grid.playerLayer[y][x]);
-                    SetConsoleTextAttribute(hConsole, WHITE);
-                }
-                else {
-                    putchar(grid.playerLayer[y][x]);
-                }
+        if (xStep != 0) { // moving horizontally: a forced neighbor appears above or below right after a wall ends
+            if ((isValid(grid, (Position) { pos.x, pos.y - 1 }, 'e') && !isValid(grid, (Position) { pos.x - xStep, pos.y - 1 }, 'e')) ||
+                (isValid(grid, (Position) { pos.x, pos.y + 1 }, 'e') && !isValid(grid, (Position) { pos.x - xStep, pos.y + 1 }, 'e'))) {
+                return pos;
             }
-            else if (grid.itemLayer[y][x] != ' ') {
-
-                // mark all collectible items with a light blue color
-                if (grid.itemLayer[y][x] == '!') {
-                    SetConsoleTextAttribute(hConsole, LIGHT_BLUE);
-                    putchar(grid.itemLayer[y][x]);
-                    SetConsoleTextAttribute(hConsole, WHITE);
-                }
-                else {
-                    putchar(grid.itemLayer[y][x]);
-                }
+        }
+        else { // moving vertically: same check to the left and right
+            if ((isValid(grid, (Position) { pos.x - 1, pos.y }, 'e') && !isValid(grid, (Position) { pos.x - 1, pos.y - yStep }, 'e')) ||
+                (isValid(grid, (Position) { pos.x + 1, pos.y }, 'e') && !isValid(grid, (Position) { pos.x + 1, pos.y - yStep }, 'e'))) {
+                return pos;
             }
-            else if (grid.wallLayer[y][x] != ' ') {
-
-                // mark the exit with a light green color
-                if (grid.wallLayer[y][x] == 'E') {
 
-                    // make the exit red for all item objective levels, then make it green when the objective is completed
-                    if (level.objectiveID == ITEM_OBJ) {
-                        SetConsoleTextAttribute(hConsole, level.itemCounts[OBJ_ITEM] > 0 ? RED : LIGHT_GREEN);
-                        putchar(grid.wallLayer[y][x]);
-                        SetConsoleTextAttribute(hConsole, WHITE);
-                    }
-                    else {
-                        SetConsoleTextAttribute(hConsole, LIGHT_GREEN);
-                        putchar(grid.wallLayer[y][x]);
-                        SetConsoleTextAttribute(hConsole, WHITE);
-                    }
-                }
-                else {
-                    putchar(grid.wallLayer[y][x]);
-                }
-            }
-            else {
-                putchar(' ');
+            // since paths can't move diagonally, a vertical jump also stops wherever a horizontal jump would find something
+            if (!matchesPosition(jumpFrom(grid, pos, 1, 0, end, scanned), INVALID_POS) || !matchesPosition(jumpFrom(grid, pos, -1, 0, end, scanned), INVALID_POS)) {
+                return pos;
             }
         }
-        putchar('\n');
-    }
-
-    // print the number of remaining objective items left in item objective levels
-    if (level.objectiveID == ITEM_OBJ) {
-
-        // turn the text to light green once all items have been collected
-        SetConsoleTextAttribute(hConsole, level.itemCounts[OBJ_ITEM] == 0 ? LIGHT_GREEN : LIGHT_BLUE);
-        printf("\t! left: %d  \n", level.itemCounts[OBJ_ITEM]);
-        SetConsoleTextAttribute(hConsole, WHITE);
     }
 }
 
-bool isValid(AllEntities grid, Position entity, char ID) {
+NavigationMap* createNavigationMap(int width, int height) {
+    NavigationMap* navMap = calloc(1, sizeof(NavigationMap)); // zeroed so that a partially built map can always be freed
+    if (navMap == NULL) {
+        fprintf(stderr, "\nMALLOC ERROR: Memory allocation for the navigation map failed!\n");
+        return NULL;
+    }
 
-    // bounds checking
-    if (entity.x < 1 || entity.x > GRID_SIZE - 2 || entity.y < 1 || entity.y > GRID_SIZE - 2) {
-        return false;
+    // allocate the A* scratch buffers once per level instead of once per search
+    navMap->cellCount = width * height;
+    navMap->closedSet = malloc(sizeof(bool) * navMap->cellCount);
+    navMap->allNodes = malloc(sizeof(Node*) * navMap->cellCount);
+    navMap->path = malloc(sizeof(Position) * navMap->cellCount);
+    if (navMap->closedSet == NULL || navMap->allNodes == NULL || navMap->path == NULL) {
+        fprintf(stderr, "\nMALLOC ERROR: Memory allocation for the pathfinding scratch buffers failed!\n");
+        freeNavigationMap(navMap);
+        return NULL;
     }
-    
-    // if the wall layer has a wall at that location
-    if (grid.wallLayer[entity.y][entity.x] == 178) {
-        return false;
+
+    // the flood fill bitboards are filled in once the walls are placed
+    navMap->playerDistances = malloc(sizeof(int) * navMap->cellCount);
+    if (!createBitboard(&navMap->open, width, height) || !createBitboard(&navMap->frontier, width, height) ||
+        !createBitboard(&navMap->nextRing, width, height) || !createBitboard(&navMap->area, width, height) ||
+        !createBitboard(&navMap->nearPlayer, width, height) || navMap->playerDistances == NULL) {
+        fprintf(stderr, "\nMALLOC ERROR: Memory allocation for the flood fill bitboards failed!\n");
+        freeNavigationMap(navMap);
+        return NULL;
     }
 
-    switch (ID) {
-    case 'e': // additional checks for enemies
+    // small boards are cheap enough to search cell by cell, so they don't need a cluster graph
+    if (width < HIERARCHICAL_MIN_SIZE && height < HIERARCHICAL_MIN_SIZE) {
+        return navMap;
+    }
 
-        // if an enemy encounters the player, allow the movement
-        if (grid.playerLayer[entity.y][entity.x] == 'X') {
-            return true;
-        }
+    // divide the board into clusters, rounding up so that the right and bottom edges are covered by smaller clusters
+    navMap->clustersWide = (width + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+    navMap->clustersHigh = (height + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+    int clusterCount = navMap->clustersWide * navMap->clustersHigh;
 
-        // prevents multiple enemies from occupying the same space
-        if (grid.playerLayer[entity.y][entity.x] != ' ') {
-            return false;
-        }
-        break;
-    case 'i': // additional checks for items
+    navMap->nodeCount = clusterCount * MAX_CLUSTER_PORTALS + 2; // +2 for the start and goal nodes
+    navMap->hasDirtyClusters = true;
 
-        // prevents multiple items from occupying the same space
-        if (grid.itemLayer[entity.y][entity.x] != ' ') {
-            return false;
-        }
-        break;
-    case 'b':
+    navMap->clusters = malloc(sizeof(Cluster) * clusterCount);
+    navMap->route = malloc(sizeof(int) * navMap->nodeCount);
 
-        // the bullet stops traveling once it hits a living entity
-        if (grid.playerLayer[entity.y][entity.x] != ' ') {
+    if (navMap->clusters == NULL || navMap->route == NULL) {
+        fprintf(stderr, "\nMALLOC ERROR: Memory allocation for the navigation map arrays failed!\n");
+        freeNavigationMap(navMap);
+        return NULL;
+    }
 
-            if (grid.playerLayer[entity.y][entity.x] == 226) {
-                return true;
-            }
-            else return false;
-        }        
-        break;
+    // every cluster starts out dirty so that all portals are built right before the first search
+    for (int y = 0; y < navMap->clustersHigh; y++) {
+        for (int x = 0; x < navMap->clustersWide; x++) {
+            Cluster* cluster = &navMap->clusters[y * navMap->clustersWide + x];
+            cluster->origin = (Position){ x * CLUSTER_SIZE, y * CLUSTER_SIZE };
+            cluster->width = (width - cluster->origin.x < CLUSTER_SIZE) ? width - cluster->origin.x : CLUSTER_SIZE;
+            cluster->height = (height - cluster->origin.y < CLUSTER_SIZE) ? height - cluster->origin.y : CLUSTER_SIZE;
+            cluster->portalCount = 0;
+            cluster->isDirty = true;
+        }
     }
-    return true;
+    return navMap;
 }
 
-bool doesDetect(Position detector, Position detectee, int detectionRadius) {
-    return abs(detector.x - detectee.x) <= detectionRadius &&
-        abs(detector.y - detectee.y) <= detectionRadius;
-}
+void freeNavigationMap(NavigationMap* navMap) {
+    if (navMap == NULL) return;
 
-bool hasLineOfSight(Position pos, Position player, unsigned char** wallLayer, int aggroRange) {
+    free(navMap->closedSet);
+    free(navMap->allNodes);
+    free(navMap->path);
 
-    // get the starting (ghost) and ending (player) coordinates
-    int xStart = pos.x;
-    int yStart = pos.y;
-    int xFinish = player.x;
-    int yFinish = player.y;
+    free(navMap->clusters);
+    free(navMap->route);
 
-    // calculate differences in coordinates
-    int dx = abs(xFinish - xStart);
-    int dy = abs(yFinish - yStart);
+    freeNextHopTable(navMap);
 
-    // return false if the enemy is too far away to see the player
-    if (dx > aggroRange || dy > aggroRange) {
-        return false;
+    freeBitboard(&navMap->open);
+    freeBitboard(&navMap->frontier);
+    freeBitboard(&navMap->nextRing);
+    freeBitboard(&navMap->area);
+    freeBitboard(&navMap->nearPlayer);
+    free(navMap->playerDistances);
+
+    free(navMap->requests);
+    for (int i = 0; i < MAX_ACTIVE_SEARCHES; i++) {
+        free(navMap->searches[i].gCosts);
+        free(navMap->searches[i].parents);
+        free(navMap->searches[i].stamps);
+        free(navMap->searches[i].heap);
     }
+    free(navMap);
+}
 
-    // determine the direction of movement along the x and y axis
-    int xStep = (xStart < xFinish) ? 1 : -1;
-    int yStep = (yStart < yFinish) ? 1 : -1;
+bool isOpenCell(AllEntities grid, Position pos) {
 
-    int err = dx - dy; // error term set to the difference in x coordinates
+    // the cluster graph only cares about walls; enemies blocking the way are handled when the move is validated
+    if (pos.x < 1 || pos.x > BOARD_WIDTH(grid) - 2 || pos.y < 1 || pos.y > BOARD_HEIGHT(grid) - 2) {
+        return false;
+    }
+    return grid.wallLayer[pos.y][pos.x] != 178;
+}
 
-    // loop until we reach the player's position
-    while (true) {
+int findCluster(NavigationMap* navMap, Position pos) {
+    return (pos.y / CLUSTER_SIZE) * navMap->clustersWide + (pos.x / CLUSTER_SIZE);
+}
 
-        // check if there is an obstacle at the current position
-        if (wallLayer[yStart][xStart] == 178) {
-            return false; // line of sight is blocked
-        }
+void clearWall(AllEntities* grid, Position pos) {
+    bool wasWall = grid->wallLayer[pos.y][pos.x] == 178;
+    grid->wallLayer[pos.y][pos.x] = ' ';
 
-        // if the current position matches the player's position, we have line of sight
-        if (xStart == xFinish && yStart == yFinish) {
-            return true; // reached the player's position
+    // only an actual wall being destroyed changes which cells are walkable
+    if (wasWall && grid->navMap != NULL) {
+        grid->navMap->wallVersion++;
+        freeNextHopTable(grid->navMap);
+        if (isOpenCell(*grid, pos)) {
+            setBit(&grid->navMap->open, pos);
         }
+        if (grid->navMap->clusters != NULL) {
+            markClusterDirty(grid->navMap, pos);
+        }
+    }
+}
 
-        int e2 = err * 2; // double the error term for comparison
+void markClusterDirty(NavigationMap* navMap, Position pos) {
+    navMap->clusters[findCluster(navMap, pos)].isDirty = true;
+    navMap->hasDirtyClusters = true;
 
-        // adjust the error term and move in the x direction if needed
-        if (e2 > -dy) {
-            err -= dy;
-            xStart += xStep;
+    // a cell on a cluster's border also decides the entrances of the neighboring cluster, so it has to be rebuilt as well
+    for (int i = 0; i < 4; i++) {
+        Position neighbor = { pos.x + dx[i], pos.y + dy[i] };
+        if (neighbor.x < 0 || neighbor.x >= navMap->clustersWide * CLUSTER_SIZE || neighbor.y < 0 || neighbor.y >= navMap->clustersHigh * CLUSTER_SIZE) continue;
 
-            // check for diagonal walls when moving in both x and y directions
-            if (wallLayer[yStart][xStart - xStep] == 178 && wallLayer[yStart - yStep][xStart] == 178) {
-                return false; // line of sight is blocked by diagonal walls
-            }
+        int neighborCluster = findCluster(navMap, neighbor);
+        if (neighborCluster != findCluster(navMap, pos)) {
+            navMap->clusters[neighborCluster].isDirty = true;
         }
+    }
+}
 
-        // adjust the error term and move in the y direction if needed
-        else if (e2 < dx) {
-            err += dx;
-            yStart += yStep;
+void addBorderPortals(AllEntities grid, Cluster* cluster, int direction) {
+
+    // the border cells of one side of the cluster, walked in order along that side
+    bool isVertical = (dx[direction] == 0);
+    int sideLength = isVertical ? cluster->width : cluster->height;
+    Position first;
+    first.x = (dx[direction] > 0) ? cluster->origin.x + cluster->width - 1 : cluster->origin.x;
+    first.y = (dy[direction] > 0) ? cluster->origin.y + cluster->height - 1 : cluster->origin.y;
+
+    /* an entrance is a run of border cells where both the cell and the cell across the border are open.
+        both clusters sharing a border find the same runs, so their portals always line up with each other. */
+    int runStart = -1;
+    for (int i = 0; i <= sideLength; i++) {
+        bool isOpen = false;
+        if (i < sideLength) {
+            Position cell = { first.x + (isVertical ? i : 0), first.y + (isVertical ? 0 : i) };
+            Position across = { cell.x + dx[direction], cell.y + dy[direction] };
+            isOpen = isOpenCell(grid, cell) && isOpenCell(grid, across);
+        }
 
-            // check for diagonal walls when moving in both x and y directions
-            if (wallLayer[yStart][xStart - xStep] == 178 && wallLayer[yStart - yStep][xStart] == 178) {
-                return false; // line of sight is blocked by diagonal walls
+        if (isOpen && runStart == -1) {
+            runStart = i;
+        }
+        else if (!isOpen && runStart != -1) {
+
+            // narrow entrances get a single portal in the middle, wide ones get a portal at each end
+            int runEnd = i - 1;
+            int offsets[2] = { (runStart + runEnd) / 2, -1 };
+            if (runEnd - runStart + 1 > MAX_ENTRANCE_WIDTH) {
+                offsets[0] = runStart;
+                offsets[1] = runEnd;
+            }
+
+            for (int j = 0; j < 2 && offsets[j] != -1; j++) {
+                Position portalPos = { first.x + (isVertical ? offsets[j] : 0), first.y + (isVertical ? 0 : offsets[j]) };
+
+                // a corner cell can be an entrance on two sides, in which case it keeps one portal with both exits
+                int index = 0;
+                while (index < cluster->portalCount && !matchesPosition(cluster->portals[index].pos, portalPos)) {
+                    index++;
+                }
+                if (index == cluster->portalCount) {
+                    cluster->portals[cluster->portalCount].pos = portalPos;
+                    cluster->portals[cluster->portalCount].exits = 0;
+                    cluster->portalCount++;
+                }
+                cluster->portals[index].exits |= 1 << direction;
             }
+            runStart = -1;
         }
     }
 }
 
-void movePatrolEnemy(AllEntities grid, Enemy* patrol, Position* newPos, Position oldPos) {
+int searchCluster(AllEntities grid, Cluster* cluster, Position start, int* distances, int* previous) {
+    int cellCount = cluster->width * cluster->height;
+    int queue[CLUSTER_SIZE * CLUSTER_SIZE];
+    int head = 0, tail = 0;
 
-    // define an array to store which directions have been tried already
-    int triedDirections[4] = { 0 };
-    int directionsTried = 0;
+    for (int i = 0; i < cellCount; i++) {
+        distances[i] = -1;
+    }
 
-    // test the current direction to see if it is valid
-    int newDirection = patrol->specialAbility;
-    newPos->x = oldPos.x + dx[newDirection];
-    newPos->y = oldPos.y + dy[newDirection];
-    
-    // if the current direction is not valid, then choose another one to move to
-    while (!isValid(grid, *newPos, 'e') && directionsTried != 4) {
+    // breadth-first search that never leaves the cluster, indexed by each cell's offset from the cluster's origin
+    int startIndex = (start.y - cluster->origin.y) * cluster->width + (start.x - cluster->origin.x);
+    distances[startIndex] = 0;
+    previous[startIndex] = -1;
+    queue[tail++] = startIndex;
 
-        // mark the current direction as tried
-        triedDirections[newDirection] = 1;
-        directionsTried++;
+    while (head < tail) {
+        int current = queue[head++];
+        Position pos = { cluster->origin.x + current % cluster->width, cluster->origin.y + current / cluster->width };
 
-        // choose another direction that hasn't been tested yet
-        do {
-            newDirection = rand() % 4;
-        } while (triedDirections[newDirection] && directionsTried != 4);
+        for (int i = 0; i < 4; i++) {
+            Position newPos = { pos.x + dx[i], pos.y + dy[i] };
+            if (newPos.x < cluster->origin.x || newPos.x >= cluster->origin.x + cluster->width ||
+                newPos.y < cluster->origin.y || newPos.y >= cluster->origin.y + cluster->height) {
+                continue;
+            }
 
-        // test the new position with the new direction again
-        newPos->x = oldPos.x + dx[newDirection];
-        newPos->y = oldPos.y + dy[newDirection];
+            int newIndex = (newPos.y - cluster->origin.y) * cluster->width + (newPos.x - cluster->origin.x);
+            if (distances[newIndex] == -1 && isOpenCell(grid, newPos)) {
+                distances[newIndex] = distances[current] + 1;
+                previous[newIndex] = current;
+                queue[tail++] = newIndex;
+            }
+        }
     }
-    patrol->specialAbility = newDirection; // finalize the new direction
+    return tail; // the number of cells reached
 }
 
-void moveTeleporterEnemy(AllEntities grid, Position* newPos, Position pos) {
-    int toleranceCounter = 0;
-    do { // generate a new random location that isn't the same as the player's
-        newPos->x = rand() % (GRID_SIZE - 2) + 1;
-        newPos->y = rand() % (GRID_SIZE - 2) + 1;
+void rebuildCluster(AllEntities grid, Cluster* cluster) {
+    int distances[CLUSTER_SIZE * CLUSTER_SIZE];
+    int previous[CLUSTER_SIZE * CLUSTER_SIZE];
 
-        // allow 100 attempts to teleport, otherwise the enemy doesn't move if the 100th attempt is still invalid
-        if (toleranceCounter == 100) break;
-        toleranceCounter++;
-    } while (!isValid(grid, *newPos, 'e') || matchesPosition(pos, *newPos));
+    // find the portals along all 4 sides of the cluster
+    cluster->portalCount = 0;
+    for (int i = 0; i < 4; i++) {
+        addBorderPortals(grid, cluster, i);
+    }
+
+    // precompute the walking distance between every pair of portals without leaving the cluster
+    for (int i = 0; i < cluster->portalCount; i++) {
+        searchCluster(grid, cluster, cluster->portals[i].pos, distances, previous);
+        for (int j = 0; j < cluster->portalCount; j++) {
+            Position other = cluster->portals[j].pos;
+            cluster->portalDistances[i][j] = distances[(other.y - cluster->origin.y) * cluster->width + (other.x - cluster->origin.x)];
+        }
+    }
+    cluster->isDirty = false;
 }
 
-void moveAllEnemies(int frameCounter, Level level, AllEntities* grid, Enemy** allEnemies, Player player, Particle** bombHead, Bullet** bulletHead) {
-    /* ENEMY MOVEMENT BEHAVIORS:
+int findPortal(Cluster* cluster, Position pos) {
+    for (int i = 0; i < cluster->portalCount; i++) {
+        if (matchesPosition(cluster->portals[i].pos, pos)) {
+            return i;
+        }
+    }
+    return -1;
+}
 
-           BASIC ENEMY: will roam to a random location on the grid. after reaching it, another random location is chosen until all possible locations
-                        have been roamed to. then the cycle restarts.
+bool pushHeapEntry(long long** heap, int* heapSize, int* heapCapacity, int node, int fCost) {
+
+    // grow the heap the same way the A* priority queue does. if it can't grow, the node is lost, so the search has to fail
+    if (*heapSize >= *heapCapacity) {
+        long long* temp = realloc(*heap, sizeof(long long) * *heapCapacity * 2);
+        if (temp == NULL) {
+            fprintf(stderr, "\nMALLOC ERROR: Memory reallocation for the pathfinding heap failed!\n");
+            return false;
+        }
+        *heap = temp;
+        *heapCapacity *= 2;
+    }
+
+    // heapify up
+    long long entry = ((long long)fCost << 32) | node;
+    int index = (*heapSize)++;
+    while (index > 0 && (*heap)[(index - 1) / 2] > entry) {
+        (*heap)[index] = (*heap)[(index - 1) / 2];
+        index = (index - 1) / 2;
+    }
+    (*heap)[index] = entry;
+    return true;
+}
+
+long long popHeapEntry(long long* heap, int* heapSize) {
+    long long root = heap[0];
+    long long last = heap[--(*heapSize)];
+
+    // heapify down
+    int index = 0;
+    while (true) {
+        int child = 2 * index + 1;
+        if (child >= *heapSize) break;
+        if (child + 1 < *heapSize && heap[child + 1] < heap[child]) {
+            child++;
+        }
+        if (heap[child] >= last) break;
+        heap[index] = heap[child];
+        index = child;
+    }
+    if (*heapSize > 0) {
+        heap[index] = last;
+    }
+    return root;
+}
+
+bool relaxPortalNode(PathSearch* search, int node, int parent, int gCost, Position nodePos, Position end) {
+    unsigned int openStamp = 2 * search->currentStamp;
+
+    // portals that have already been expanded this search are final, the same as cells in the grid searches
+    if (search->stamps[node] == openStamp + 1) {
+        return true;
+    }
+
+    // only keep the new cost if the node hasn't been reached this search or the new route is shorter
+    if (search->stamps[node] != openStamp || gCost < search->gCosts[node]) {
+        search->stamps[node] = openStamp;
+        search->gCosts[node] = gCost;
+        search->parents[node] = parent;
+        return pushHeapEntry(&search->heap, &search->heapSize, &search->heapCapacity, node, gCost + calculateHCost(nodePos, end));
+    }
+    return true;
+}
+
+bool appendClusterPath(AllEntities grid, Cluster* cluster, Position from, Position to, Position* path, int* pathLength, int maxLength) {
+    int distances[CLUSTER_SIZE * CLUSTER_SIZE];
+    int previous[CLUSTER_SIZE * CLUSTER_SIZE];
+    Position segment[CLUSTER_SIZE * CLUSTER_SIZE];
+    int segmentLength = 0;
+
+    // refine one hop of the abstract route by searching only the cluster it crosses
+    searchCluster(grid, cluster, from, distances, previous);
+    int index = (to.y - cluster->origin.y) * cluster->width + (to.x - cluster->origin.x);
+    if (distances[index] == -1) {
+        return false;
+    }
+
+    // walk back from the destination, skipping the starting cell since it is already on the path
+    while (previous[index] != -1) {
+        segment[segmentLength++] = (Position){ cluster->origin.x + index % cluster->width, cluster->origin.y + index / cluster->width };
+        index = previous[index];
+    }
+    if (*pathLength + segmentLength > maxLength) {
+        return false;
+    }
+    for (int i = segmentLength - 1; i >= 0; i--) {
+        path[(*pathLength)++] = segment[i];
+    }
+    return true;
+}
+
+bool rebuildDirtyClusters(AllEntities grid) {
+    NavigationMap* navMap = grid.navMap;
+    if (!navMap->hasDirtyClusters) {
+        return true;
+    }
+
+    /* rebuilding a cluster searches it once per portal, so it's charged for those cells. once the budget runs out the
+        rest wait for the next frame, which keeps the first search of a large level from rebuilding the whole graph at once. */
+    for (int i = 0; i < navMap->clustersWide * navMap->clustersHigh; i++) {
+        Cluster* cluster = &navMap->clusters[i];
+        if (!cluster->isDirty) continue;
+        if (navMap->frameBudget <= 0) {
+            return false;
+        }
+
+        rebuildCluster(grid, cluster);
+        navMap->frameBudget -= CLUSTER_SIZE * CLUSTER_SIZE * (cluster->portalCount + 1);
+    }
+    navMap->hasDirtyClusters = false;
+    return true;
+}
+
+bool startHierarchicalSearch(AllEntities grid, PathRequest* request) {
+    NavigationMap* navMap = grid.navMap;
+    PathSearch* search = request->search;
+    int previous[CLUSTER_SIZE * CLUSTER_SIZE];
+
+    if (!isOpenCell(grid, request->end)) {
+        return false;
+    }
+
+    // connect the start and goal to the portals of their own clusters, charging the two cluster searches
+    searchCluster(grid, &navMap->clusters[findCluster(navMap, request->start)], request->start, search->startDistances, previous);
+    searchCluster(grid, &navMap->clusters[findCluster(navMap, request->end)], request->end, search->goalDistances, previous);
+    navMap->frameBudget -= 2 * CLUSTER_SIZE * CLUSTER_SIZE;
+
+    // bumping the stamp forgets every node from the slot's last search without clearing the arrays
+    search->currentStamp++;
+    search->heapSize = 0;
+    return relaxPortalNode(search, navMap->nodeCount - 2, -1, 0, request->start, request->end);
+}
+
+SearchStatus stepHierarchicalSearch(AllEntities grid, PathRequest* request, int* expansions) {
+    NavigationMap* navMap = grid.navMap;
+    PathSearch* search = request->search;
+    Position start = request->start;
+    Position end = request->end;
+    int maxExpansions = *expansions;
+    unsigned int openStamp = 2 * search->currentStamp;
+    int startNode = navMap->nodeCount - 2;
+    int goalNode = navMap->nodeCount - 1;
+    int startClusterIndex = findCluster(navMap, start);
+    int goalClusterIndex = findCluster(navMap, end);
+    Cluster* startCluster = &navMap->clusters[startClusterIndex];
+    Cluster* goalCluster = &navMap->clusters[goalClusterIndex];
+    *expansions = 0;
+
+    // A* over the abstract graph: the nodes are portals, and the edges are the precomputed distances between them.
+    // a node that can't be pushed because the heap couldn't grow fails the search, since the path it was on is lost
+    while (*expansions < maxExpansions) {
+        if (search->heapSize == 0) {
+            return SEARCH_FAILED; // the goal can't be reached from the start
+        }
+
+        // skip the leftover entries of nodes that were pushed again with a shorter route and have since been expanded
+        int node = (int)(popHeapEntry(search->heap, &search->heapSize) & 0xFFFFFFFF);
+        if (search->stamps[node] != openStamp) continue;
+
+        search->stamps[node] = openStamp + 1;
+        (*expansions)++;
+
+        if (node == goalNode) {
+            return SEARCH_FOUND;
+        }
+
+        int gCost = search->gCosts[node];
+        if (node == startNode) {
+
+            // the start can walk to any portal of its own cluster, or straight to the goal if it shares that cluster
+            for (int i = 0; i < startCluster->portalCount; i++) {
+                Position portalPos = startCluster->portals[i].pos;
+                int distance = search->startDistances[(portalPos.y - startCluster->origin.y) * startCluster->width + (portalPos.x - startCluster->origin.x)];
+                if (distance != -1) {
+                    if (!relaxPortalNode(search, startClusterIndex * MAX_CLUSTER_PORTALS + i, node, gCost + distance, portalPos, end)) return SEARCH_FAILED;
+                }
+            }
+            if (startClusterIndex == goalClusterIndex) {
+                int distance = search->startDistances[(end.y - startCluster->origin.y) * startCluster->width + (end.x - startCluster->origin.x)];
+                if (distance != -1) {
+                    if (!relaxPortalNode(search, goalNode, node, gCost + distance, end, end)) return SEARCH_FAILED;
+                }
+            }
+            continue;
+        }
+
+        int clusterIndex = node / MAX_CLUSTER_PORTALS;
+        int portalIndex = node % MAX_CLUSTER_PORTALS;
+        Cluster* cluster = &navMap->clusters[clusterIndex];
+        Portal* portal = &cluster->portals[portalIndex];
+
+        // walk to the other portals within the same cluster
+        for (int i = 0; i < cluster->portalCount; i++) {
+            int distance = cluster->portalDistances[portalIndex][i];
+            if (i != portalIndex && distance != -1) {
+                if (!relaxPortalNode(search, clusterIndex * MAX_CLUSTER_PORTALS + i, node, gCost + distance, cluster->portals[i].pos, end)) return SEARCH_FAILED;
+            }
+        }
+
+        // step across the border into the matching portal of each neighboring cluster
+        for (int i = 0; i < 4; i++) {
+            if (!(portal->exits & (1 << i))) continue;
+
+            Position across = { portal->pos.x + dx[i], portal->pos.y + dy[i] };
+            int acrossCluster = findCluster(navMap, across);
+            int acrossPortal = findPortal(&navMap->clusters[acrossCluster], across);
+            if (acrossPortal != -1) {
+                if (!relaxPortalNode(search, acrossCluster * MAX_CLUSTER_PORTALS + acrossPortal, node, gCost + 1, across, end)) return SEARCH_FAILED;
+            }
+        }
+
+        // walk from a portal of the goal's cluster to the goal itself
+        if (clusterIndex == goalClusterIndex) {
+            int distance = search->goalDistances[(portal->pos.y - goalCluster->origin.y) * goalCluster->width + (portal->pos.x - goalCluster->origin.x)];
+            if (distance != -1) {
+                if (!relaxPortalNode(search, goalNode, node, gCost + distance, end, end)) return SEARCH_FAILED;
+            }
+        }
+    }
+    return SEARCH_RUNNING;
+}
+
+bool buildHierarchicalPath(AllEntities grid, PathRequest* request, Position* path, int* pathLength, int maxLength) {
+    NavigationMap* navMap = grid.navMap;
+    PathSearch* search = request->search;
+    int goalNode = navMap->nodeCount - 1;
+
+    // collect the abstract route in order from the start to the goal
+    int routeLength = 0;
+    for (int node = goalNode; node != -1; node = search->parents[node]) {
+        navMap->route[routeLength++] = node;
+    }
+
+    // refine the route into individual steps by searching locally between each pair of consecutive nodes
+    *pathLength = 0;
+    path[(*pathLength)++] = request->start;
+    Position from = request->start;
+    for (int i = routeLength - 2; i >= 0; i--) {
+        int node = navMap->route[i];
+        Position to = (node == goalNode) ? request->end : navMap->clusters[node / MAX_CLUSTER_PORTALS].portals[node % MAX_CLUSTER_PORTALS].pos;
+
+        int fromCluster = findCluster(navMap, from);
+        if (fromCluster != findCluster(navMap, to)) {
+
+            // consecutive portals in different clusters are always adjacent across their shared border
+            if (*pathLength >= maxLength) return false;
+            path[(*pathLength)++] = to;
+        }
+        else {
+            navMap->frameBudget -= CLUSTER_SIZE * CLUSTER_SIZE; // each local search is charged for the cluster it searches
+            if (!appendClusterPath(grid, &navMap->clusters[fromCluster], from, to, path, pathLength, maxLength)) {
+                return false;
+            }
+        }
+        from = to;
+    }
+    return true;
+}
+
+bool buildNextHopTable(AllEntities grid) {
+    NavigationMap* navMap = grid.navMap;
+    int width = BOARD_WIDTH(grid);
+
+    navMap->openCells = malloc(sizeof(int) * navMap->cellCount);
+    if (navMap->openCells == NULL) {
+        fprintf(stderr, "\nMALLOC ERROR: Memory allocation for the next-hop table failed!\n");
+        return false;
+    }
+
+    // number the open cells (the same ones the cluster graph walks on), and leave large boards to the searches
+    int openCount = 0;
+    for (int cell = 0; cell < navMap->cellCount; cell++) {
+        Position pos = { cell % width, cell / width };
+        navMap->openCells[cell] = isOpenCell(grid, pos) ? openCount++ : -1;
+    }
+    if (openCount == 0 || openCount > NEXT_HOP_MAX_CELLS) {
+        freeNextHopTable(navMap);
+        return false;
+    }
+    navMap->openCount = openCount;
+
+    navMap->nextHops = calloc(((size_t)openCount * openCount + 3) / 4, 1);
+    navMap->openAreas = malloc(sizeof(int) * openCount);
+    int* queue = malloc(sizeof(int) * openCount);
+    int* reachedFor = malloc(sizeof(int) * openCount); // the target each open cell was last reached from, so it's never cleared
+    if (navMap->nextHops == NULL || navMap->openAreas == NULL || queue == NULL || reachedFor == NULL) {
+        fprintf(stderr, "\nMALLOC ERROR: Memory allocation for the next-hop table failed!\n");
+        free(queue);
+        free(reachedFor);
+        freeNextHopTable(navMap);
+        return false;
+    }
+    for (int i = 0; i < openCount; i++) {
+        navMap->openAreas[i] = -1;
+        reachedFor[i] = -1;
+    }
+
+    /* a breadth-first search out from each target reaches every other cell of its area by a shortest path, so the
+        first step from a cell toward the target is just the step the search took to reach it, reversed. */
+    int areaCount = 0;
+    for (int cell = 0; cell < navMap->cellCount; cell++) {
+        int target = navMap->openCells[cell];
+        if (target < 0) continue;
+
+        int area = (navMap->openAreas[target] >= 0) ? navMap->openAreas[target] : areaCount++;
+        size_t rowStart = (size_t)target * openCount;
+        navMap->openAreas[target] = area;
+        reachedFor[target] = target;
+
+        int head = 0, tail = 0;
+        queue[tail++] = cell;
+        while (head < tail) {
+            int current = queue[head++];
+            for (int i = 0; i < 4; i++) {
+
+                // open cells are never on the edge of the board, so their neighbors are always on it
+                int neighbor = current + dy[i] * width + dx[i];
+                int open = navMap->openCells[neighbor];
+                if (open < 0 || reachedFor[open] == target) continue;
+
+                // the opposite of each direction in dx/dy is the one next to it (up and down, then left and right)
+                size_t entry = rowStart + open;
+                navMap->nextHops[entry / 4] |= (unsigned char)((i ^ 1) << (entry % 4 * 2));
+                navMap->openAreas[open] = area;
+                reachedFor[open] = target;
+                queue[tail++] = neighbor;
+            }
+        }
+    }
+
+    free(queue);
+    free(reachedFor);
+    return true;
+}
+
+void freeNextHopTable(NavigationMap* navMap) {
+    free(navMap->nextHops);
+    free(navMap->openCells);
+    free(navMap->openAreas);
+    navMap->nextHops = NULL;
+    navMap->openCells = NULL;
+    navMap->openAreas = NULL;
+    navMap->openCount = 0;
+}
+
+// the first step of a shortest path over the walls alone. false if there's no table or no path, so the caller can search instead
+bool findNextHop(AllEntities grid, Position from, Position to, Position* next) {
+    NavigationMap* navMap = grid.navMap;
+    if (navMap->nextHops == NULL) {
+        return false;
+    }
+
+    int fromOpen = navMap->openCells[from.y * BOARD_WIDTH(grid) + from.x];
+    int toOpen = navMap->openCells[to.y * BOARD_WIDTH(grid) + to.x];
+    if (fromOpen < 0 || toOpen < 0 || navMap->openAreas[fromOpen] != navMap->openAreas[toOpen]) {
+        return false;
+    }
+    if (fromOpen == toOpen) {
+        *next = from;
+        return true;
+    }
+
+    size_t entry = (size_t)toOpen * navMap->openCount + fromOpen;
+    int direction = (navMap->nextHops[entry / 4] >> (entry % 4 * 2)) & 3;
+    *next = (Position){ from.x + dx[direction], from.y + dy[direction] };
+    return true;
+}
+
+bool createBitboard(Bitboard* board, int width, int height) {
+    board->wordsPerRow = (width + 63) / 64;
+    board->height = height;
+    board->words = calloc((size_t)board->wordsPerRow * height, sizeof(uint64_t));
+    return board->words != NULL;
+}
+
+void freeBitboard(Bitboard* board) {
+    free(board->words);
+    board->words = NULL;
+}
+
+bool testBit(const Bitboard* board, Position pos) {
+    return (board->words[pos.y * board->wordsPerRow + pos.x / 64] >> (pos.x % 64)) & 1;
+}
+
+void setBit(Bitboard* board, Position pos) {
+    board->words[pos.y * board->wordsPerRow + pos.x / 64] |= 1ULL << (pos.x % 64);
+}
+
+// the index of the lowest set bit of a word that isn't 0
+int lowestSetBit(uint64_t bits) {
+    unsigned long bit;
+#if defined(_M_X64) || defined(_M_ARM64)
+    _BitScanForward64(&bit, bits);
+#else
+    // 32 bit builds only have the 32 bit scan, so the high half is only scanned when the low half is empty
+    if (!_BitScanForward(&bit, (unsigned long)(bits & 0xFFFFFFFF))) {
+        _BitScanForward(&bit, (unsigned long)(bits >> 32));
+        bit += 32;
+    }
+#endif
+    return (int)bit;
+}
+
+void fillOpenBitboard(AllEntities grid) {
+    Bitboard* open = &grid.navMap->open;
+    memset(open->words, 0, sizeof(uint64_t) * open->wordsPerRow * open->height);
+
+    for (int y = 0; y < BOARD_HEIGHT(grid); y++) {
+        for (int x = 0; x < BOARD_WIDTH(grid); x++) {
+            Position pos = { x, y };
+            if (isOpenCell(grid, pos)) {
+                setBit(open, pos);
+            }
+        }
+    }
+}
+
+/* a breadth-first search over the walls alone, grown a whole ring at a time instead of a cell at a time. the next ring
+    is every open cell next to the last ring that hasn't been reached yet, which for a row is just the last ring's row
+    shifted left and right, or'd with the rows above and below it, then masked by the open cells. rows outside the
+    ring's top and bottom are skipped, so each ring costs a few word operations per row it spans. reached ends up
+    holding every cell within maxDistance steps of start, and distances (if given) the steps to each of them.
+    returns the distance to the farthest ring. */
+int floodFill(NavigationMap* navMap, Position start, int maxDistance, Bitboard* reached, int* distances, int width) {
+    int words = navMap->open.wordsPerRow;
+    int height = navMap->open.height;
+    Bitboard frontier = navMap->frontier;
+    Bitboard next = navMap->nextRing;
+
+    memset(reached->words, 0, sizeof(uint64_t) * words * height);
+    memset(frontier.words + start.y * words, 0, sizeof(uint64_t) * words);
+    setBit(&frontier, start);
+    setBit(reached, start);
+    if (distances != NULL) {
+        distances[start.y * width + start.x] = 0;
+    }
+
+    int top = start.y, bottom = start.y;
+    int distance = 0;
+    while (distance < maxDistance) {
+        int nextTop = height, nextBottom = -1;
+        int firstRow = (top > 0) ? top - 1 : 0;
+        int lastRow = (bottom < height - 1) ? bottom + 1 : height - 1;
+
+        for (int y = firstRow; y <= lastRow; y++) {
+
+            // the frontier's rows outside top..bottom still hold older rings, so they count as empty
+            const uint64_t* row = (y >= top && y <= bottom) ? frontier.words + y * words : NULL;
+            const uint64_t* above = (y - 1 >= top && y - 1 <= bottom) ? frontier.words + (y - 1) * words : NULL;
+            const uint64_t* below = (y + 1 >= top && y + 1 <= bottom) ? frontier.words + (y + 1) * words : NULL;
+            const uint64_t* openRow = navMap->open.words + y * words;
+            const uint64_t* reachedRow = reached->words + y * words;
+            uint64_t* grownRow = next.words + y * words;
+
+            uint64_t rowBits = 0;
+            for (int w = 0; w < words; w++) {
+                uint64_t spread = 0;
+                if (row != NULL) {
+                    // the end bits of neighboring words carry over, for boards wider than one word
+                    spread = (row[w] << 1) | (row[w] >> 1);
+                    if (w > 0) spread |= row[w - 1] >> 63;
+                    if (w + 1 < words) spread |= row[w + 1] << 63;
+                }
+                if (above != NULL) spread |= above[w];
+                if (below != NULL) spread |= below[w];
+
+                grownRow[w] = spread & openRow[w] & ~reachedRow[w];
+                rowBits |= grownRow[w];
+            }
+
+            if (rowBits != 0) {
+                if (y < nextTop) nextTop = y;
+                nextBottom = y;
+            }
+        }
+
+        // the fill has covered everything it can reach
+        if (nextBottom < 0) break;
+        distance++;
+
+        for (int y = nextTop; y <= nextBottom; y++) {
+            for (int w = 0; w < words; w++) {
+                uint64_t bits = next.words[y * words + w];
+                reached->words[y * words + w] |= bits;
+
+                // only the cells of the new ring are written, one per set bit
+                while (distances != NULL && bits != 0) {
+                    distances[y * width + w * 64 + lowestSetBit(bits)] = distance;
+                    bits &= bits - 1;
+                }
+            }
+        }
+
+        Bitboard swap = frontier;
+        frontier = next;
+        next = swap;
+        top = nextTop;
+        bottom = nextBottom;
+    }
+    return distance;
+}
+
+// fills navMap->area with every cell reachable from start, reusing the last fill while no wall has been destroyed and start is inside it
+void findReachableArea(AllEntities grid, Position start) {
+    NavigationMap* navMap = grid.navMap;
+    if (navMap->hasArea && navMap->areaWallVersion == navMap->wallVersion && testBit(&navMap->area, start)) {
+        return;
+    }
+
+    floodFill(navMap, start, navMap->cellCount, &navMap->area, NULL, BOARD_WIDTH(grid));
+    navMap->hasArea = true;
+    navMap->areaWallVersion = navMap->wallVersion;
+}
+
+// steps from the player to pos over the walls alone, or -1 if it's farther than PLAYER_DISTANCE_LIMIT (or unreachable)
+int findPlayerDistance(AllEntities grid, Position player, Position pos) {
+    NavigationMap* navMap = grid.navMap;
+
+    // the map is only refilled the first time it's asked for after the player moves or a wall is destroyed
+    if (!navMap->hasDistances || !matchesPosition(navMap->distancesFrom, player) || navMap->distancesWallVersion != navMap->wallVersion) {
+        floodFill(navMap, player, PLAYER_DISTANCE_LIMIT, &navMap->nearPlayer, navMap->playerDistances, BOARD_WIDTH(grid));
+        navMap->hasDistances = true;
+        navMap->distancesFrom = player;
+        navMap->distancesWallVersion = navMap->wallVersion;
+    }
+
+    if (!testBit(&navMap->nearPlayer, pos)) {
+        return -1;
+    }
+    return navMap->playerDistances[pos.y * BOARD_WIDTH(grid) + pos.x];
+}
+
+bool requestEnemyPath(NavigationMap* navMap, Enemy* enemy) {
+
+    // an enemy only ever has one request in the queue, which picks up its latest LSP once the search starts
+    for (int i = 0; i < navMap->requestCount; i++) {
+        if (navMap->requests[i].enemy == enemy) {
+            return true;
+        }
+    }
+
+    // grow the queue the same way the A* priority queue does
+    if (navMap->requestCount >= navMap->requestCapacity) {
+        int newCapacity = (navMap->requestCapacity > 0) ? navMap->requestCapacity * 2 : 16;
+        PathRequest* temp = realloc(navMap->requests, sizeof(PathRequest) * newCapacity);
+        if (temp == NULL) {
+            fprintf(stderr, "\nMALLOC ERROR: Memory reallocation for the path request queue failed!\n");
+            return false;
+        }
+        navMap->requests = temp;
+        navMap->requestCapacity = newCapacity;
+    }
+
+    PathRequest* request = &navMap->requests[navMap->requestCount++];
+    request->enemy = enemy;
+    request->search = NULL;
+    return true;
+}
+
+void servicePathRequests(AllEntities grid) {
+    NavigationMap* navMap = grid.navMap;
+
+    /* the searches take turns expanding PATH_SLICE nodes each until the frame's budget runs out. a search that doesn't
+        finish keeps its place and picks up where it left off next frame, so no number of enemies re-planning at once
+        can push a frame past the budget. the cells that jumps and cluster searches scan are charged as well, so a frame
+        only goes over by the last of those, and whatever it goes over by comes out of the next frame's budget.
+        requests are always referenced by index since finishing one can grow the queue. */
+    while (navMap->frameBudget > 0 && navMap->requestCount > 0) {
+
+        // a search over the cluster graph can't carry on once the graph changes under it, so it goes back to waiting and starts over
+        for (int i = 0; i < navMap->requestCount && i < MAX_ACTIVE_SEARCHES; i++) {
+            PathRequest* request = &navMap->requests[i];
+            if (request->search != NULL && isHierarchicalRequest(navMap, request) && request->wallVersion != navMap->wallVersion) {
+                request->search->inUse = false;
+                request->search = NULL;
+            }
+        }
+
+        // hand any free search slots to the oldest waiting requests
+        for (int i = 0; i < navMap->requestCount && i < MAX_ACTIVE_SEARCHES && navMap->frameBudget > 0; i++) {
+            if (navMap->requests[i].search != NULL) continue;
+
+            // the cluster graph has to be rebuilt before a search over it can start, which can take more than one frame
+            if (navMap->clusters != NULL && navMap->requests[i].enemy->searchType == ASTAR_SEARCH && !rebuildDirtyClusters(grid)) {
+                break;
+            }
+
+            navMap->frameBudget--; // starting a search is charged too, so a run of failed starts still ends
+            if (!startPathSearch(grid, &navMap->requests[i])) {
+                finishPathRequest(grid, i, SEARCH_FAILED, 0);
+                i--;
+            }
+        }
+
+        // share out the budget before any searching, so that each search's slice doesn't depend on how fast the others ran
+        int activeCount = 0;
+        int unallotted = navMap->frameBudget;
+        while (activeCount < navMap->requestCount && activeCount < MAX_ACTIVE_SEARCHES && navMap->requests[activeCount].search != NULL) {
+            PathRequest* request = &navMap->requests[activeCount++];
+            request->sliceBudget = (unallotted < PATH_SLICE) ? unallotted : PATH_SLICE;
+            request->expansions = 0;
+            request->status = SEARCH_RUNNING;
+            unallotted -= request->sliceBudget;
+        }
+        if (activeCount == 0) break;
+
+        // the searches only read the grid and the cluster graph and write to their own slots, so they can all step at once
+        runParallel(grid.workers, stepPathSearchTask, &grid, activeCount, 2);
+
+        // then finish the searches in queue order, since delivering a path or roaming somewhere else isn't safe to do in parallel
+        for (int i = 0; i < activeCount; i++) {
+            PathRequest* request = &navMap->requests[i];
+            int pathLength = 0;
+            if (request->status == SEARCH_FOUND && !buildSearchPath(grid, request, navMap->path, &pathLength)) {
+                request->status = SEARCH_FAILED;
+            }
+            navMap->frameBudget -= request->expansions;
+
+            if (request->status != SEARCH_RUNNING) {
+                finishPathRequest(grid, i, request->status, pathLength);
+                i--;
+                activeCount--;
+            }
+        }
+    }
+}
+
+bool startPathSearch(AllEntities grid, PathRequest* request) {
+    NavigationMap* navMap = grid.navMap;
+    Enemy* enemy = request->enemy;
+
+    // search from wherever the enemy is now to its latest LSP
+    request->start = enemy->pos;
+    request->end = enemy->playerLSP;
+    request->searchType = enemy->searchType;
+    request->wallVersion = navMap->wallVersion;
+    if (matchesPosition(request->end, INVALID_POS)) {
+        return false;
+    }
+
+    // there's always a free slot, since only the first MAX_ACTIVE_SEARCHES requests are ever started
+    PathSearch* search = NULL;
+    for (int i = 0; i < MAX_ACTIVE_SEARCHES; i++) {
+        if (!navMap->searches[i].inUse) {
+            search = &navMap->searches[i];
+            break;
+        }
+    }
+    if (search == NULL) {
+        return false;
+    }
+
+    /* allocate the slot's arrays the first time it's used, then keep them for the rest of the level. they're indexed by
+        cell for the grid searches and by portal node for the cluster graph, so they're sized for whichever is larger. */
+    if (search->gCosts == NULL) {
+        int slotSize = (navMap->nodeCount > navMap->cellCount) ? navMap->nodeCount : navMap->cellCount;
+        search->gCosts = malloc(sizeof(int) * slotSize);
+        search->parents = malloc(sizeof(int) * slotSize);
+        search->stamps = calloc(slotSize, sizeof(unsigned int));
+        search->heapCapacity = 128;
+        search->heap = malloc(sizeof(long long) * search->heapCapacity);
+        if (search->gCosts == NULL || search->parents == NULL || search->stamps == NULL || search->heap == NULL) {
+            fprintf(stderr, "\nMALLOC ERROR: Memory allocation for a path search slot failed!\n");
+            free(search->gCosts);
+            free(search->parents);
+            free(search->stamps);
+            free(search->heap);
+            search->gCosts = NULL;
+            search->parents = NULL;
+            search->stamps = NULL;
+            search->heap = NULL;
+            return false;
+        }
+    }
+
+    search->inUse = true;
+    request->search = search;
+    if (isHierarchicalRequest(navMap, request)) {
+        return startHierarchicalSearch(grid, request);
+    }
+
+    // bumping the stamp forgets every cell from the slot's last search without clearing the arrays
+    search->currentStamp++;
+    search->heapSize = 0;
+    return pushSearchCell(grid, search, request->start.y * BOARD_WIDTH(grid) + request->start.x, -1, 0, request->end);
+}
+
+bool pushSearchCell(AllEntities grid, PathSearch* search, int cell, int parent, int gCost, Position end) {
+    unsigned int openStamp = 2 * search->currentStamp;
+
+    // cells that have already been expanded this search are final
+    if (search->stamps[cell] == openStamp + 1) {
+        return true;
+    }
+
+    // only keep the new cost if the cell hasn't been reached this search or the new route is shorter
+    if (search->stamps[cell] != openStamp || gCost < search->gCosts[cell]) {
+        Position pos = { cell % BOARD_WIDTH(grid), cell / BOARD_WIDTH(grid) };
+        search->stamps[cell] = openStamp;
+        search->gCosts[cell] = gCost;
+        search->parents[cell] = parent;
+        return pushHeapEntry(&search->heap, &search->heapSize, &search->heapCapacity, cell, gCost + calculateHCost(pos, end));
+    }
+    return true;
+}
+
+void stepPathSearchTask(void* context, int item) {
+    AllEntities* grid = context;
+    PathRequest* request = &grid->navMap->requests[item];
+
+    if (request->sliceBudget > 0) {
+        request->expansions = request->sliceBudget;
+        request->status = stepPathSearch(*grid, request, &request->expansions);
+    }
+}
+
+bool isHierarchicalRequest(NavigationMap* navMap, PathRequest* request) {
+    return request->searchType == ASTAR_SEARCH && navMap->clusters != NULL;
+}
+
+SearchStatus stepPathSearch(AllEntities grid, PathRequest* request, int* expansions) {
+    PathSearch* search = request->search;
+    int maxExpansions = *expansions;
+    int width = BOARD_WIDTH(grid);
+    unsigned int openStamp = 2 * search->currentStamp;
+    if (isHierarchicalRequest(grid.navMap, request)) {
+        return stepHierarchicalSearch(grid, request, expansions);
+    }
+    *expansions = 0;
+
+    while (*expansions < maxExpansions) {
+        if (search->heapSize == 0) {
+            return SEARCH_FAILED; // the LSP can't be reached
+        }
+
+        // skip the leftover entries of cells that were pushed again with a shorter route and have since been expanded
+        int cell = (int)(popHeapEntry(search->heap, &search->heapSize) & 0xFFFFFFFF);
+        if (search->stamps[cell] != openStamp) continue;
+
+        search->stamps[cell] = openStamp + 1;
+        (*expansions)++;
+
+        // the path itself is built once the search is finished, back on the main thread
+        Position pos = { cell % width, cell / width };
+        if (matchesPosition(pos, request->end)) {
+            return SEARCH_FOUND;
+        }
+
+        if (request->searchType == JUMP_POINT_SEARCH) {
+
+            // prune the neighbors: keep going straight or turn, but never head back the way the path came from
+            int parent = search->parents[cell];
+            int xTravel = (parent >= 0) ? pos.x - parent % width : 0;
+            int yTravel = (parent >= 0) ? pos.y - parent / width : 0;
+            for (int i = 0; i < 4; i++) {
+                if ((xTravel > 0 && dx[i] < 0) || (xTravel < 0 && dx[i] > 0) || (yTravel > 0 && dy[i] < 0) || (yTravel < 0 && dy[i] > 0)) {
+                    continue;
+                }
+
+                // a jump can scan whole rows and columns, so every cell it steps onto is charged on top of the expansion
+                Position jumpPoint = jumpFrom(grid, pos, dx[i], dy[i], request->end, expansions);
+                if (!matchesPosition(jumpPoint, INVALID_POS) &&
+                    !pushSearchCell(grid, search, jumpPoint.y * width + jumpPoint.x, cell, search->gCosts[cell] + calculateHCost(pos, jumpPoint), request->end)) {
+                    return SEARCH_FAILED; // the heap couldn't grow, so the jump point would be lost
+                }
+            }
+        }
+        else {
+            for (int i = 0; i < 4; i++) {
+                Position newPos = { pos.x + dx[i], pos.y + dy[i] };
+                if (isValid(grid, newPos, 'e') && !pushSearchCell(grid, search, newPos.y * width + newPos.x, cell, search->gCosts[cell] + 1, request->end)) {
+                    return SEARCH_FAILED; // the heap couldn't grow, so the neighbor would be lost
+                }
+            }
+        }
+    }
+    return SEARCH_RUNNING;
+}
+
+bool buildSearchPath(AllEntities grid, PathRequest* request, Position* path, int* pathLength) {
+    PathSearch* search = request->search;
+    int width = BOARD_WIDTH(grid);
+    if (isHierarchicalRequest(grid.navMap, request)) {
+        return buildHierarchicalPath(grid, request, path, pathLength, grid.navMap->cellCount);
+    }
+
+    int cell = request->end.y * width + request->end.x;
+    int stepCount = search->gCosts[cell] + 1;
+    if (stepCount > grid.navMap->cellCount) {
+        return false;
+    }
+
+    // walk back from the goal, filling in the straight runs between jump points (A* parents are always a single step apart)
+    int index = stepCount - 1;
+    while (search->parents[cell] >= 0) {
+        int parent = search->parents[cell];
+        Position to = { cell % width, cell / width };
+        Position from = { parent % width, parent / width };
+        int xStep = (to.x > from.x) - (to.x < from.x);
+        int yStep = (to.y > from.y) - (to.y < from.y);
+        for (Position pos = to; !matchesPosition(pos, from); pos.x -= xStep, pos.y -= yStep) {
+            path[index--] = pos;
+        }
+        cell = parent;
+    }
+    path[0] = request->start;
+    *pathLength = stepCount;
+    return true;
+}
+
+void finishPathRequest(AllEntities grid, int index, SearchStatus status, int pathLength) {
+    NavigationMap* navMap = grid.navMap;
+    PathRequest request = navMap->requests[index];
+    Enemy* enemy = request.enemy;
+
+    // free the search slot and take the request out of the queue, keeping the rest of it in order
+    if (request.search != NULL) {
+        request.search->inUse = false;
+    }
+    memmove(&navMap->requests[index], &navMap->requests[index + 1], sizeof(PathRequest) * (navMap->requestCount - index - 1));
+    navMap->requestCount--;
+
+    if (status == SEARCH_FOUND) {
+
+        /* the enemy may have kept walking its old path while this one was searched, so the new path is cached from
+            wherever the enemy is now. if the enemy isn't on it at all, it's dropped and the enemy re-plans on its next move. */
+        for (int i = 0; i < pathLength; i++) {
+            if (matchesPosition(navMap->path[i], enemy->pos)) {
+                cachePath(enemy, navMap->path + i, pathLength - i, request.wallVersion);
+                break;
+            }
+        }
+    }
+    else if (!matchesPosition(request.end, INVALID_POS) && matchesPosition(request.end, enemy->playerLSP)) {
+        roamToUnvisited(enemy, grid); // roam to another random location if the path is impossible
+    }
+}
+
+// runs one path request from start to finish through the same sliced searches the enemies use, ignoring the frame budget
+bool runPathRequest(AllEntities grid, SearchType searchType, Position start, Position end, Position* path, int* pathLength) {
+    NavigationMap* navMap = grid.navMap;
+    Enemy enemy = { 0 };
+    enemy.pos = start;
+    enemy.playerLSP = end;
+    enemy.searchType = searchType;
+
+    PathRequest request = { 0 };
+    request.enemy = &enemy;
+
+    // the budget is only refilled so that the cluster graph's rebuild and searches can always go ahead
+    navMap->frameBudget = PATH_BUDGET_PER_FRAME;
+    while (navMap->clusters != NULL && searchType == ASTAR_SEARCH && !rebuildDirtyClusters(grid)) {
+        navMap->frameBudget = PATH_BUDGET_PER_FRAME;
+    }
+
+    SearchStatus status = SEARCH_FAILED;
+    if (startPathSearch(grid, &request)) {
+        do {
+            int expansions = PATH_SLICE;
+            status = stepPathSearch(grid, &request, &expansions);
+        } while (status == SEARCH_RUNNING);
+
+        if (status == SEARCH_FOUND && !buildSearchPath(grid, &request, path, pathLength)) {
+            status = SEARCH_FAILED;
+        }
+    }
+
+    if (request.search != NULL) {
+        request.search->inUse = false;
+    }
+    return status == SEARCH_FOUND;
+}
+
+void drawGameState(AllEntities grid, Level level) {
+    HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE); // used to change the color of text
+    setCursorPosition(0, 2); // reset the cursor to the start of the third line to overwrite the grid
+
+    for (int y = 0; y < grid.height; y++) {
+        for (int x = 0; x < grid.width; x++) {
+
+            // order of precedence: beings are printed on top, then items, then the walls
+            if (grid.playerLayer[y][x] != ' ') {
+
+                // mark the player with a red color
+                if (grid.playerLayer[y][x] == 'X') {
+                    SetConsoleTextAttribute(hConsole, LIGHT_GREEN);
+                    putchar(grid.playerLayer[y][x]);
+                    SetConsoleTextAttribute(hConsole, WHITE);
+                }
+                else {
+                    putchar(grid.playerLayer[y][x]);
+                }
+            }
+            else if (grid.itemLayer[y][x] != ' ') {
+
+                // mark all collectible items with a light blue color
+                if (grid.itemLayer[y][x] == '!') {
+                    SetConsoleTextAttribute(hConsole, LIGHT_BLUE);
+                    putchar(grid.itemLayer[y][x]);
+                    SetConsoleTextAttribute(hConsole, WHITE);
+                }
+                else {
+                    putchar(grid.itemLayer[y][x]);
+                }
+            }
+            else if (grid.wallLayer[y][x] != ' ') {
+
+                // mark the exit with a light green color
+                if (grid.wallLayer[y][x] == 'E') {
+
+                    // make the exit red for all item objective levels, then make it green when the objective is completed
+                    if (level.objectiveID == ITEM_OBJ) {
+                        SetConsoleTextAttribute(hConsole, level.itemCounts[OBJ_ITEM] > 0 ? RED : LIGHT_GREEN);
+                        putchar(grid.wallLayer[y][x]);
+                        SetConsoleTextAttribute(hConsole, WHITE);
+                    }
+                    else {
+                        SetConsoleTextAttribute(hConsole, LIGHT_GREEN);
+                        putchar(grid.wallLayer[y][x]);
+                        SetConsoleTextAttribute(hConsole, WHITE);
+                    }
+                }
+                else {
+                    putchar(grid.wallLayer[y][x]);
+                }
+            }
+            else {
+                putchar(' ');
+            }
+        }
+        putchar('\n');
+    }
+
+    // print the number of remaining objective items left in item objective levels
+    if (level.objectiveID == ITEM_OBJ) {
+
+        // turn the text to light green once all items have been collected
+        SetConsoleTextAttribute(hConsole, level.itemCounts[OBJ_ITEM] == 0 ? LIGHT_GREEN : LIGHT_BLUE);
+        printf("\t! left: %d  \n", level.itemCounts[OBJ_ITEM]);
+        SetConsoleTextAttribute(hConsole, WHITE);
+    }
+}
+
+bool isValid(AllEntities grid, Position entity, char ID) {
+
+    // bounds checking
+    if (entity.x < 1 || entity.x > BOARD_WIDTH(grid) - 2 || entity.y < 1 || entity.y > BOARD_HEIGHT(grid) - 2) {
+        return false;
+    }
+    
+    // if the wall layer has a wall at that location
+    if (grid.wallLayer[entity.y][entity.x] == 178) {
+        return false;
+    }
+
+    switch (ID) {
+    case 'e': // additional checks for enemies
+
+        // if an enemy encounters the player, allow the movement
+        if (grid.playerLayer[entity.y][entity.x] == 'X') {
+            return true;
+        }
+
+        // prevents multiple enemies from occupying the same space
+        if (grid.playerLayer[entity.y][entity.x] != ' ') {
+            return false;
+        }
+        break;
+    case 'i': // additional checks for items
+
+        // prevents multiple items from occupying the same space
+        if (grid.itemLayer[entity.y][entity.x] != ' ') {
+            return false;
+        }
+        break;
+    case 'b':
+
+        // the bullet stops traveling once it hits a living entity
+        if (grid.playerLayer[entity.y][entity.x] != ' ') {
+
+            if (grid.playerLayer[entity.y][entity.x] == 226) {
+                return true;
+            }
+            else return false;
+        }        
+        break;
+    }
+    return true;
+}
+
+bool doesDetect(Position detector, Position detectee, int detectionRadius) {
+    return abs(detector.x - detectee.x) <= detectionRadius &&
+        abs(detector.y - detectee.y) <= detectionRadius;
+}
+
+bool hasLineOfSight(Position pos, Position player, unsigned char** wallLayer, int aggroRange) {
+
+    // get the starting (ghost) and ending (player) coordinates
+    int xStart = pos.x;
+    int yStart = pos.y;
+    int xFinish = player.x;
+    int yFinish = player.y;
+
+    // calculate differences in coordinates
+    int dx = abs(xFinish - xStart);
+    int dy = abs(yFinish - yStart);
+
+    // return false if the enemy is too far away to see the player
+    if (dx > aggroRange || dy > aggroRange) {
+        return false;
+    }
+
+    // determine the direction of movement along the x and y axis
+    int xStep = (xStart < xFinish) ? 1 : -1;
+    int yStep = (yStart < yFinish) ? 1 : -1;
+
+    int err = dx - dy; // error term set to the difference in x coordinates
+
+    // loop until we reach the player's position
+    while (true) {
+
+        // check if there is an obstacle at the current position
+        if (wallLayer[yStart][xStart] == 178) {
+            return false; // line of sight is blocked
+        }
+
+        // if the current position matches the player's position, we have line of sight
+        if (xStart == xFinish && yStart == yFinish) {
+            return true; // reached the player's position
+        }
+
+        int e2 = err * 2; // double the error term for comparison
+
+        // adjust the error term and move in the x direction if needed
+        if (e2 > -dy) {
+            err -= dy;
+            xStart += xStep;
+
+            // check for diagonal walls when moving in both x and y directions
+            if (wallLayer[yStart][xStart - xStep] == 178 && wallLayer[yStart - yStep][xStart] == 178) {
+                return false; // line of sight is blocked by diagonal walls
+            }
+        }
+
+        // adjust the error term and move in the y direction if needed
+        else if (e2 < dx) {
+            err += dx;
+            yStart += yStep;
+
+            // check for diagonal walls when moving in both x and y directions
+            if (wallLayer[yStart][xStart - xStep] == 178 && wallLayer[yStart - yStep][xStart] == 178) {
+                return false; // line of sight is blocked by diagonal walls
+            }
+        }
+    }
+}
+
+void movePatrolEnemy(AllEntities grid, Enemy* patrol, Position* newPos, Position oldPos) {
+
+    // define an array to store which directions have been tried already
+    int triedDirections[4] = { 0 };
+    int directionsTried = 0;
+
+    // test the current direction to see if it is valid
+    int newDirection = patrol->specialAbility;
+    newPos->x = oldPos.x + dx[newDirection];
+    newPos->y = oldPos.y + dy[newDirection];
+    
+    // if the current direction is not valid, then choose another one to move to
+    while (!isValid(grid, *newPos, 'e') && directionsTried != 4) {
+
+        // mark the current direction as tried
+        triedDirections[newDirection] = 1;
+        directionsTried++;
+
+        // choose another direction that hasn't been tested yet
+        do {
+            newDirection = rand() % 4;
+        } while (triedDirections[newDirection] && directionsTried != 4);
+
+        // test the new position with the new direction again
+        newPos->x = oldPos.x + dx[newDirection];
+        newPos->y = oldPos.y + dy[newDirection];
+    }
+    patrol->specialAbility = newDirection; // finalize the new direction
+}
+
+void moveTeleporterEnemy(AllEntities grid, Position* newPos, Position pos) {
+    int toleranceCounter = 0;
+    do { // generate a new random location that isn't the same as the player's
+        newPos->x = rand() % (grid.width - 2) + 1;
+        newPos->y = rand() % (grid.height - 2) + 1;
+
+        // allow 100 attempts to teleport, otherwise the enemy doesn't move if the 100th attempt is still invalid
+        if (toleranceCounter == 100) break;
+        toleranceCounter++;
+    } while (!isValid(grid, *newPos, 'e') || matchesPosition(pos, *newPos));
+}
+
+void moveAllEnemies(int frameCounter, AllEntities* grid, Enemy** allEnemies, EnemyScheduler* scheduler, Player player, Particle** bombHead, Bullet** bulletHead) {
+    /* ENEMY MOVEMENT BEHAVIORS:
+
+           BASIC ENEMY: will roam to a random location on the grid. after reaching it, another random location is chosen until all possible locations
+                        have been roamed to. then the cycle restarts.
            PATROL ENEMY: will continue to move in a straight line, then will turn to a random direction upon hitting a wall.
            TELEPORTER ENEMY: remains stationary for a set interval until it randomly teleports to a different location.
            CHASER ENEMY: will make random moves until it sees the player within a vision radius, then will chase
@@ -816,239 +2343,589 @@ void moveAllEnemies(int frameCounter, Level level, AllEntities* grid, Enemy** al
            TRAPPER ENEMY: moves in the same fashion as the basic enemy, but drops bombs upon random intervals that will
                             blow up any surrounding walls after 10 seconds and will kill the player if they are within the blast radius.
            BURST ENEMY: remains stationary then moves to a random location. if it sees the player, then it targets their location next
-           SHOOTER ENEMY: will shoot at the player from a distance and can be seen from afar, bullets can damage walls */
+           SHOOTER ENEMY: will shoot at the player from a distance and can be seen from afar, bullets can damage walls
+
+       each behavior is an update kernel in enemyKernels. rather than polling every enemy every frame, each kernel says how many
+       frames until its enemy next does anything, and the enemy sleeps on the scheduler's timer wheel until then. */
+
+    // refill the pathfinding budget (less anything last frame went over by), then let last frame's unfinished searches go first
+    grid->navMap->frameBudget = PATH_BUDGET_PER_FRAME + ((grid->navMap->frameBudget < 0) ? grid->navMap->frameBudget : 0);
+    servicePathRequests(*grid);
+
+    EnemyFrame frame;
+    frame.frameCounter = frameCounter;
+    frame.grid = grid;
+    frame.allEnemies = allEnemies;
+    frame.scheduler = scheduler;
+    frame.player = player;
+    frame.bombHead = bombHead;
+    frame.bulletHead = bulletHead;
+
+    // the move interval of the trapper is initially every 10 frames with a 50% chance to set a bomb at its next roaming location.
+    // however, the move interval slowly shortens over 2 minutes until it reaches 0, upon which it will move every frame.
+    // the probability of setting a bomb will also slowly increase from 50% to 100% over 2 minutes.
+    int maxTrapperTime = 1200;
+    int initialTrapperInterval = 10;
+    int initialProbability = 50;
+    frame.trapperInterval = initialTrapperInterval - (initialTrapperInterval * frameCounter / maxTrapperTime);
+    frame.bombSpawnChance = initialProbability + (initialProbability * frameCounter / maxTrapperTime);
+
+    // calculating the burst enemy's move interval to be shorter as more time passes (50 frames initially, then shortens to 0)
+    int initialBurstInterval = 50;
+    int maxBurstTime = 900;
+    frame.burstInterval = initialBurstInterval - (initialBurstInterval * frameCounter / maxBurstTime);
+
+    // take the enemies waking this frame out of their slot, leaving the ones due on a later turn of the wheel
+    WheelSlot* slot = &scheduler->slots[frameCounter & (WHEEL_SLOTS - 1)];
+    int dueCount = 0;
+    int keptCount = 0;
+    for (int i = 0; i < slot->count; i++) {
+        if (slot->entries[i].wakeFrame == (unsigned int)frameCounter) {
+            scheduler->due[dueCount++] = slot->entries[i];
+        }
+        else {
+            slot->entries[keptCount++] = slot->entries[i];
+        }
+    }
+    slot->count = keptCount;
+
+    // enemies always move in type then index order, no matter what order they were scheduled in, which also keeps each kernel's runs together
+    qsort(scheduler->due, dueCount, sizeof(WakeEntry), compareWakeEntries);
+
+    /* planning phase: line of sight only depends on the walls and the player, neither of which an enemy's move changes,
+        so every due enemy can check it at once before any of them move. everything else happens in order below. */
+    scheduler->sightCount = 0;
+    for (int i = 0; i < dueCount; i++) {
+        Enemy* enemy = &allEnemies[scheduler->due[i].type][scheduler->due[i].index];
+        int radius = sightRadii[scheduler->due[i].type];
+
+        scheduler->seesPlayer[i] = false;
+        if (radius > 0) {
+            int n = scheduler->sightCount++;
+            scheduler->sightX[n] = enemy->pos.x;
+            scheduler->sightY[n] = enemy->pos.y;
+            scheduler->sightRange[n] = radius;
+            scheduler->sightItems[n] = i;
+        }
+    }
+    int batchCount = (scheduler->sightCount + SIGHT_BATCH - 1) / SIGHT_BATCH;
+    runParallel(grid->workers, planEnemySight, &frame, batchCount, MIN_PARALLEL_SIGHT_BATCHES);
+
+    for (int i = 0; i < dueCount; i++) {
+        int type = scheduler->due[i].type;
+        Enemy* enemy = &allEnemies[type][scheduler->due[i].index];
+
+        // by default, wake again at the end of the enemy's next move interval
+        EnemyMove move;
+        move.newPos = enemy->pos;
+        move.LSPflag = false;
+        move.isBullet = false;
+        move.seesPlayer = scheduler->seesPlayer[i];
+        move.wakeDelay = enemy->moveInterval - frameCounter % enemy->moveInterval;
+
+        enemyKernels[type](&frame, enemy, &move);
+        finishEnemyMove(&frame, enemy, &move);
+
+        // this can't fail, since createEnemyScheduler already gave every slot room for the whole level
+        if (move.wakeDelay > 0) {
+            scheduleEnemy(scheduler, type, scheduler->due[i].index, frameCounter + move.wakeDelay);
+        }
+    }
+}
+
+EnemyScheduler* createEnemyScheduler(Level level, Enemy** allEnemies) {
+    EnemyScheduler* scheduler = calloc(1, sizeof(EnemyScheduler)); // zeroed so that a partially built scheduler can always be freed
+    if (scheduler == NULL) {
+        fprintf(stderr, "\nMALLOC ERROR: Memory allocation for the enemy scheduler failed!\n");
+        return NULL;
+    }
 
-    // iterate thru each enemy type
+    int enemyCount = 0;
     for (int i = 0; i < NUM_ENEMY_TYPES; i++) {
+        enemyCount += level.enemyCounts[i];
+    }
 
-        // skip all absent enemy types
-        if (level.enemyCounts[i] == 0) continue;
+    // every enemy could wake on the same frame, so the scratch arrays have room for all of them
+    scheduler->due = malloc(sizeof(WakeEntry) * (enemyCount > 0 ? enemyCount : 1));
+    scheduler->seesPlayer = malloc(sizeof(bool) * (enemyCount > 0 ? enemyCount : 1));
+    scheduler->sightX = malloc(sizeof(int) * (enemyCount > 0 ? enemyCount : 1));
+    scheduler->sightY = malloc(sizeof(int) * (enemyCount > 0 ? enemyCount : 1));
+    scheduler->sightRange = malloc(sizeof(int) * (enemyCount > 0 ? enemyCount : 1));
+    scheduler->sightItems = malloc(sizeof(int) * (enemyCount > 0 ? enemyCount : 1));
+    if (scheduler->due == NULL || scheduler->seesPlayer == NULL || scheduler->sightX == NULL || scheduler->sightY == NULL ||
+        scheduler->sightRange == NULL || scheduler->sightItems == NULL) {
+        fprintf(stderr, "\nMALLOC ERROR: Memory allocation for the enemy wakeup list failed!\n");
+        freeEnemyScheduler(scheduler);
+        return NULL;
+    }
+
+    // an enemy only ever sits in one slot at a time, so a slot with room for every enemy never has to grow mid-game
+    for (int i = 0; i < WHEEL_SLOTS; i++) {
+        scheduler->slots[i].entries = malloc(sizeof(WakeEntry) * (enemyCount > 0 ? enemyCount : 1));
+        if (scheduler->slots[i].entries == NULL) {
+            fprintf(stderr, "\nMALLOC ERROR: Memory allocation for an enemy scheduler slot failed!\n");
+            freeEnemyScheduler(scheduler);
+            return NULL;
+        }
+        scheduler->slots[i].capacity = (enemyCount > 0 ? enemyCount : 1);
+    }
 
-        // iterate thru each enemy of that enemy type
+    // the game loop starts at frame 1, so each enemy first wakes on the first multiple of its move interval
+    for (int i = 0; i < NUM_ENEMY_TYPES; i++) {
         for (int j = 0; j < level.enemyCounts[i]; j++) {
+            if (!scheduleEnemy(scheduler, i, j, allEnemies[i][j].moveInterval)) {
+                freeEnemyScheduler(scheduler);
+                return NULL;
+            }
+        }
+    }
+    return scheduler;
+}
 
-            // only move the current enemy if the current frame is at the end of their move interval
-            if (frameCounter % allEnemies[i][j].moveInterval != 0) continue;
+void freeEnemyScheduler(EnemyScheduler* scheduler) {
+    if (scheduler == NULL) return;
 
-            const Position oldPos = allEnemies[i][j].pos;
-            Position newPos = oldPos;
-            Position path[NUM_SQUARES];
-            int pathLength = 0;
-            bool LSPflag = false;
-            bool isBullet = false;
-
-            switch (i) {
-            case BASIC_ENEMY:
-            {   // will always roam to a random location on the grid, no aggro state
-                if (matchesPosition(allEnemies[i][j].playerLSP, INVALID_POS)) {
-                    roamToUnvisited(&allEnemies[i][j], *grid);
-                }
-                LSPflag = true;
-                break;
-            }
-            case PATROL_ENEMY:
-            {   // for this enemy, specialAbility will hold a number between 0-3 inclusive to represent its current direction to travel in
-                movePatrolEnemy(*grid, &allEnemies[i][j], &newPos, oldPos);
-                break;
-            }
-            case TELEPORT_ENEMY:
-            {   // for this enemy, specialAbility will represent the number of movement intervals passed before the enemy actually teleports
-                // specialAbility is used instead of its normally defined movement interval in order to be able to implement its flickering effect
-                if (allEnemies[i][j].specialAbility > 0) {
-                    allEnemies[i][j].specialAbility--;
+    for (int i = 0; i < WHEEL_SLOTS; i++) {
+        free(scheduler->slots[i].entries);
+    }
+    free(scheduler->due);
+    free(scheduler->seesPlayer);
+    free(scheduler->sightX);
+    free(scheduler->sightY);
+    free(scheduler->sightRange);
+    free(scheduler->sightItems);
+    free(scheduler);
+}
 
-                    // make the enemy flicker between its passive and aggro states to indicate that its movement interval is soon (10 frames away)
-                    if (allEnemies[i][j].specialAbility <= 10) {
+bool scheduleEnemy(EnemyScheduler* scheduler, int type, int index, unsigned int wakeFrame) {
+    WheelSlot* slot = &scheduler->slots[wakeFrame & (WHEEL_SLOTS - 1)];
 
-                        /* the layer must be directly updated rather than changing the isAggro status of the enemy.
-                           this is because the isValid check at the end of each iteration will override the flickering effect.
-                           sure, the aggro status itself will flicker, but it wont be shown on the grid directly. */
-                        grid->playerLayer[oldPos.y][oldPos.x] = (frameCounter % 2 == 0) ? passiveEnemyMarkers[TELEPORT_ENEMY] : aggroEnemyMarkers[TELEPORT_ENEMY];
-                    }
-                    else {
-                        grid->playerLayer[oldPos.y][oldPos.x] = allEnemies[i][j].passiveMarker;
-                    }
-                }
-                else { // teleport when the interval is done
-                    moveTeleporterEnemy(*grid, &newPos, player.pos);
-                    allEnemies[i][j].specialAbility = 35; // reset the interval to 35 frames
-                }
-                break;
-            }
-            case CHASER_ENEMY:
-            {
-                // check every frame if the chaser has line of sight of the player
-                if (hasLineOfSight(oldPos, player.pos, grid->wallLayer, AGGRO_RADIUS)) {
-                    allEnemies[i][j].playerLSP = player.pos; // update the player's LSP
-                    allEnemies[i][j].isAggro = true;
-                }
+    // slots start with room for every enemy, but grow the same way the A* priority queue does just in case
+    if (slot->count >= slot->capacity) {
+        int newCapacity = (slot->capacity > 0) ? slot->capacity * 2 : 8;
+        WakeEntry* temp = realloc(slot->entries, sizeof(WakeEntry) * newCapacity);
+        if (temp == NULL) {
+            fprintf(stderr, "\nMALLOC ERROR: Memory reallocation for an enemy scheduler slot failed!\n");
+            return false;
+        }
+        slot->entries = temp;
+        slot->capacity = newCapacity;
+    }
 
-                // if aggro'd, then move every 2 frames towards the player
-                if (allEnemies[i][j].isAggro && frameCounter % 2 == 0) {
-                    LSPflag = true;
-                }
-                else { // if not aggro'd, then make a random move every 10 frames
-                    if (allEnemies[i][j].specialAbility > 0) {
-                        allEnemies[i][j].specialAbility--;
-                    }
-                    else {
-                        LSPflag = true;
-                        allEnemies[i][j].specialAbility = 10; // resetting the move timer
-                    }
-                }
-                break;
-            }
-            case TRAPPER_ENEMY:
-            {   // the move interval of this enemy is initially every 7 frames with a 50% chance to set a bomb at its next roaming location.
-                // however, the move interval slowly shortens over 2 minutes until it reaches 0, upon which it will move every frame.
-                // the probability of setting a bomb will also slowly increase from 50% to 100% over 2 minutes.
-                int maxTime = 1200;
-                int initialInterval = 10;
-                int initialProbability = 50;
-                int newMoveInterval = initialInterval - (initialInterval * frameCounter / maxTime);
-                int bombSpawnChance = initialProbability + (initialProbability * frameCounter / maxTime);
-
-                if (allEnemies[i][j].specialAbility > 0) {
-                    allEnemies[i][j].specialAbility--;
-                }
-                else {
-                    // movement behavior is the same as the braindead enemy
-                    if (matchesPosition(allEnemies[i][j].playerLSP, INVALID_POS)) {
-                        roamToUnvisited(&allEnemies[i][j], *grid);
+    WakeEntry* entry = &slot->entries[slot->count++];
+    entry->wakeFrame = wakeFrame;
+    entry->type = type;
+    entry->index = index;
+    return true;
+}
 
-                        // chance to set a bomb every time the random location is reached
-                        setBomb(bombHead, newPos, grid->itemLayer, bombSpawnChance);
-                    }
-                    allEnemies[i][j].specialAbility = newMoveInterval;
-                    LSPflag = true;
-                }
-                break;
-            }
-            case BURST_ENEMY:
-            {
-                // calculating the move interval to be shorter as more time passes (50 frames initially, then shortens to 0)
-                int initialInterval = 50;
-                int maxTime = 900;
-                int newMoveInterval = initialInterval - (initialInterval * frameCounter / maxTime);
+int compareWakeEntries(const void* a, const void* b) {
+    const WakeEntry* entryA = a;
+    const WakeEntry* entryB = b;
 
-                // after maxTime frames pass, the enemy will pursue the player indefinitely while permanently skipping the passive phase
-                if (newMoveInterval < 0) {
-                    allEnemies[i][j].playerLSP = player.pos;
-                }
+    if (entryA->type != entryB->type) {
+        return entryA->type - entryB->type;
+    }
+    return entryA->index - entryB->index;
+}
 
-                // only have the enemy move when it is aggro'd (therefore, it is only active when aggro'd)
-                if (allEnemies[i][j].isAggro) {
-                    LSPflag = true;
-                    break;
-                }
+int skipCountdown(Enemy* enemy, int wakeValue) {
 
-                // travel phase: the enemy beelines straight for the player's exact location.
-                //      -- it is important to note that this enemy will always keep moving until the LSP is reached
-                if (allEnemies[i][j].specialAbility > 0) {
-                    allEnemies[i][j].specialAbility--;
+    /* a countdown that's only being decremented has nothing to show until it gets down to wakeValue, so it's jumped
+        straight there and the enemy sleeps thru the frames in between. returns the frames until the enemy next wakes. */
+    if (enemy->specialAbility <= wakeValue) {
+        return 1;
+    }
+    int skippedFrames = enemy->specialAbility - wakeValue;
+    enemy->specialAbility = wakeValue;
+    return skippedFrames + 1;
+}
 
-                    // flicker for 10 frames to indicate burst movement is happening soon
-                    if (allEnemies[i][j].specialAbility <= 10) {
-                        grid->playerLayer[oldPos.y][oldPos.x] = (frameCounter % 2 == 0) ? passiveEnemyMarkers[BURST_ENEMY] : aggroEnemyMarkers[BURST_ENEMY];
-                    }
-                    else {
-                        grid->playerLayer[oldPos.y][oldPos.x] = allEnemies[i][j].passiveMarker;
-                    }
-                }
-                else { // passive phase: sits still for a decreasingly short interval
+WorkerPool* createWorkerPool(void) {
+    WorkerPool* pool = calloc(1, sizeof(WorkerPool));
+    if (pool == NULL) {
+        fprintf(stderr, "\nMALLOC ERROR: Memory allocation for the worker pool failed!\n");
+        return NULL;
+    }
 
-                    // target the player's exact location
-                    allEnemies[i][j].playerLSP = player.pos;
+    // one thread per core, counting the game's own thread
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    pool->workerCount = (systemInfo.dwNumberOfProcessors < MAX_PLANNING_THREADS) ? (int)systemInfo.dwNumberOfProcessors : MAX_PLANNING_THREADS;
 
-                    // activating the burst enemy once the interval is done
-                    allEnemies[i][j].isAggro = true;
+    pool->work = CreateThreadpoolWork(runWorker, pool, NULL);
+    if (pool->work == NULL) {
+        fprintf(stderr, "\nERROR: The thread pool work object could not be created!\n");
+        free(pool);
+        return NULL;
+    }
+    return pool;
+}
 
-                    // resetting the interval to a shorter one
-                    allEnemies[i][j].specialAbility = newMoveInterval;
-                }
-                break;
-            }
-            case SHOOTER_ENEMY:
-                // switch to aggro behavior if the shooter sees the player
-                if (hasLineOfSight(oldPos, player.pos, grid->wallLayer, AGGRO_RADIUS * 2)) {
-                    allEnemies[i][j].isAggro = true;
-                    allEnemies[i][j].playerLSP = player.pos;
+void freeWorkerPool(WorkerPool* pool) {
+    if (pool == NULL) return;
 
-                    if (frameCounter % 10 == 0) {
-                        LSPflag = true;
-                    }
+    CloseThreadpoolWork(pool->work);
+    free(pool);
+}
 
-                    if (allEnemies[i][j].specialAbility > 0) {
-                        allEnemies[i][j].specialAbility--;
-                    }
-                    else {
-                        allEnemies[i][j].specialAbility = 0;
-                        isBullet = true;
-                    }
-                }
-                else { // define the enemy's passive behavior
+void runParallel(WorkerPool* pool, ParallelTask task, void* context, int itemCount, int minParallelItems) {
 
-                    // find another position to roam to if the current one is already reached
-                    if (matchesPosition(allEnemies[i][j].playerLSP, INVALID_POS)) {
-                        roamToUnvisited(&allEnemies[i][j], *grid);
-                        allEnemies[i][j].specialAbility = 0;
-                    }
+    // small jobs are quicker to just run here than to wake up the pool for
+    if (pool == NULL || pool->workerCount < 2 || itemCount < minParallelItems) {
+        for (int i = 0; i < itemCount; i++) {
+            task(context, i);
+        }
+        return;
+    }
 
-                    // move only every 20 frames
-                    if (frameCounter % 20 == 0) {
-                        LSPflag = true;
-                    }
-                }
-                break;
-            }
+    pool->task = task;
+    pool->context = context;
+    pool->itemCount = itemCount;
+    pool->nextItem = -1;
 
-            if (LSPflag) {
+    // the pool's threads and this one all claim items until there are none left, then this waits for the rest to finish theirs
+    int workerCount = (itemCount < pool->workerCount) ? itemCount : pool->workerCount;
+    for (int i = 1; i < workerCount; i++) {
+        SubmitThreadpoolWork(pool->work);
+    }
+    claimWorkerItems(pool);
+    WaitForThreadpoolWorkCallbacks(pool->work, FALSE);
+}
 
-                // move to the player's LSP if known
-                if (!matchesPosition(allEnemies[i][j].playerLSP, INVALID_POS)) {
+VOID CALLBACK runWorker(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work) {
+    claimWorkerItems(context);
+}
 
-                    // use the A* pathfinding algorithm to go to the player's LSP
-                    if (findPath(*grid, oldPos, allEnemies[i][j].playerLSP, path, &pathLength)) {
+void claimWorkerItems(WorkerPool* pool) {
+    LONG item;
+    while ((item = InterlockedIncrement(&pool->nextItem)) < pool->itemCount) {
+        pool->task(pool->context, item);
+    }
+}
 
-                        // either move to the next step of the path or move directly if the destination is reached
-                        newPos = (pathLength > 1) ? path[1] : path[0];
-                    }
-                    else { // roam to another random location if the path is impossible
-                        roamToUnvisited(&allEnemies[i][j], *grid);
-                    }
+void planEnemySight(void* context, int batch) {
+    EnemyFrame* frame = context;
+    EnemyScheduler* scheduler = frame->scheduler;
+    int start = batch * SIGHT_BATCH;
+    int count = scheduler->sightCount - start < SIGHT_BATCH ? scheduler->sightCount - start : SIGHT_BATCH;
+    bool results[SIGHT_BATCH];
 
-                    // set the LSP to an invalid location once reached then de-aggro the enemy
-                    if (matchesPosition(allEnemies[i][j].pos, allEnemies[i][j].playerLSP)) {
-                        allEnemies[i][j].playerLSP = INVALID_POS;
-                        allEnemies[i][j].isAggro = false;
-                    }
-                }
-                else { // if LSP is unknown, make a random move instead                    
-                    makeRandomMove(*grid, &newPos, oldPos);
-                    allEnemies[i][j].isAggro = false;
-                }
-            }
+    hasLineOfSightBatch(scheduler->sightX + start, scheduler->sightY + start, scheduler->sightRange + start, count,
+        frame->player.pos, frame->grid, results);
+
+    // hand each result back to the enemy's slot in the due list
+    for (int i = 0; i < count; i++) {
+        scheduler->seesPlayer[scheduler->sightItems[start + i]] = results[i];
+    }
+}
 
-            if (isBullet && LSPflag) {
-                int a = findBulletDirection(oldPos, newPos);
+/* gives the same answers as calling hasLineOfSight on each enemy in turn. built with AVX2, 8 lines are walked at once,
+    each lane taking the same Bresenham steps as the scalar version and dropping out once it hits a wall or the player.
+    the scalar version's diagonal wall check always looks at the cell it just left, which already passed the wall check,
+    so it can never block a line and the lanes skip it. whatever doesn't fill a whole set of lanes goes through the scalar version. */
+void hasLineOfSightBatch(const int* xs, const int* ys, const int* ranges, int count, Position player, AllEntities* grid, bool* results) {
+    int i = 0;
+
+#ifdef __AVX2__
+    // the wall layer is one contiguous block, so each lane's cell can be gathered straight out of it (the padding after
+    // the last cell keeps the 4 byte loads in bounds, and only the low byte of each is kept)
+    const int* cells = (const int*)grid->wallLayer[0];
+    __m256i width = _mm256_set1_epi32(BOARD_WIDTH(*grid));
+    __m256i playerX = _mm256_set1_epi32(player.x);
+    __m256i playerY = _mm256_set1_epi32(player.y);
+    __m256i wallMarker = _mm256_set1_epi32(178);
+    __m256i lowByte = _mm256_set1_epi32(0xFF);
+    __m256i allSet = _mm256_set1_epi32(-1);
+    __m256i zero = _mm256_setzero_si256();
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(xs + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(ys + i));
+        __m256i range = _mm256_loadu_si256((const __m256i*)(ranges + i));
+
+        __m256i dx = _mm256_abs_epi32(_mm256_sub_epi32(playerX, x));
+        __m256i dy = _mm256_abs_epi32(_mm256_sub_epi32(playerY, y));
+        __m256i negativeDy = _mm256_sub_epi32(zero, dy);
+
+        // step 1 towards the player, or -1 when already level with it, the same as the scalar version
+        __m256i xTowards = _mm256_cmpgt_epi32(playerX, x);
+        __m256i yTowards = _mm256_cmpgt_epi32(playerY, y);
+        __m256i xStep = _mm256_sub_epi32(allSet, _mm256_add_epi32(xTowards, xTowards));
+        __m256i yStep = _mm256_sub_epi32(allSet, _mm256_add_epi32(yTowards, yTowards));
+
+        __m256i err = _mm256_sub_epi32(dx, dy);
+
+        // lanes too far away to see the player never start walking
+        __m256i outOfRange = _mm256_or_si256(_mm256_cmpgt_epi32(dx, range), _mm256_cmpgt_epi32(dy, range));
+        __m256i active = _mm256_andnot_si256(outOfRange, allSet);
+        __m256i seen = zero;
+
+        while (!_mm256_testz_si256(active, active)) {
+
+            // a wall on the current cell blocks the line
+            __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(y, width), x);
+            __m256i cell = _mm256_and_si256(_mm256_i32gather_epi32(cells, index, 1), lowByte);
+            active = _mm256_andnot_si256(_mm256_cmpeq_epi32(cell, wallMarker), active);
+
+            // reaching the player's cell means the enemy can see them
+            __m256i reached = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi32(x, playerX), _mm256_cmpeq_epi32(y, playerY)), active);
+            seen = _mm256_or_si256(seen, reached);
+            active = _mm256_andnot_si256(reached, active);
+
+            // move each lane still walking in x, or else in y (finished lanes stay where they stopped)
+            __m256i e2 = _mm256_add_epi32(err, err);
+            __m256i moveX = _mm256_and_si256(_mm256_cmpgt_epi32(e2, negativeDy), active);
+            __m256i moveY = _mm256_andnot_si256(moveX, _mm256_and_si256(_mm256_cmpgt_epi32(dx, e2), active));
+            err = _mm256_sub_epi32(err, _mm256_and_si256(dy, moveX));
+            x = _mm256_add_epi32(x, _mm256_and_si256(xStep, moveX));
+            err = _mm256_add_epi32(err, _mm256_and_si256(dx, moveY));
+            y = _mm256_add_epi32(y, _mm256_and_si256(yStep, moveY));
+        }
 
-                *bulletHead = shootBullet(*bulletHead, allEnemies[i][j].pos, a);
-            }
+        int seenLanes = _mm256_movemask_ps(_mm256_castsi256_ps(seen));
+        for (int lane = 0; lane < 8; lane++) {
+            results[i + lane] = (seenLanes >> lane) & 1;
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        Position pos = { xs[i], ys[i] };
+        results[i] = hasLineOfSight(pos, player, grid->wallLayer, ranges[i]);
+    }
+}
+
+void updateBasicEnemy(EnemyFrame* frame, Enemy* enemy, EnemyMove* move) {
+
+    // will always roam to a random location on the grid, no aggro state
+    if (matchesPosition(enemy->playerLSP, INVALID_POS)) {
+        roamToUnvisited(enemy, *frame->grid);
+    }
+    move->LSPflag = true;
+}
+
+void updatePatrolEnemy(EnemyFrame* frame, Enemy* enemy, EnemyMove* move) {
+
+    // for this enemy, specialAbility will hold a number between 0-3 inclusive to represent its current direction to travel in
+    movePatrolEnemy(*frame->grid, enemy, &move->newPos, enemy->pos);
+}
+
+void updateTeleportEnemy(EnemyFrame* frame, Enemy* enemy, EnemyMove* move) {
+    AllEntities* grid = frame->grid;
+    Position oldPos = enemy->pos;
+
+    // for this enemy, specialAbility will represent the number of movement intervals passed before the enemy actually teleports
+    // specialAbility is used instead of its normally defined movement interval in order to be able to implement its flickering effect
+    if (enemy->specialAbility > 0) {
+        enemy->specialAbility--;
+
+        // make the enemy flicker between its passive and aggro states to indicate that its movement interval is soon (10 frames away)
+        if (enemy->specialAbility <= 10) {
+
+            /* the layer must be directly updated rather than changing the isAggro status of the enemy.
+               this is because the isValid check at the end of each iteration will override the flickering effect.
+               sure, the aggro status itself will flicker, but it wont be shown on the grid directly. */
+            grid->playerLayer[oldPos.y][oldPos.x] = (frame->frameCounter % 2 == 0) ? passiveEnemyMarkers[TELEPORT_ENEMY] : aggroEnemyMarkers[TELEPORT_ENEMY];
+        }
+        else {
+            grid->playerLayer[oldPos.y][oldPos.x] = enemy->passiveMarker;
+        }
+    }
+    else { // teleport when the interval is done
+        moveTeleporterEnemy(*grid, &move->newPos, frame->player.pos);
+        enemy->specialAbility = 35; // reset the interval to 35 frames
+    }
+
+    // sleep until the countdown is one frame away from flickering
+    move->wakeDelay = skipCountdown(enemy, 11);
+}
+
+void updateChaserEnemy(EnemyFrame* frame, Enemy* enemy, EnemyMove* move) {
+
+    // check every frame if the chaser has line of sight of the player
+    if (move->seesPlayer) {
+        enemy->playerLSP = frame->player.pos; // update the player's LSP
+        enemy->isAggro = true;
+    }
+
+    // if aggro'd, then move every 2 frames towards the player
+    if (enemy->isAggro && frame->frameCounter % 2 == 0) {
+        move->LSPflag = true;
+    }
+    else { // if not aggro'd, then make a random move every 10 frames
+        if (enemy->specialAbility > 0) {
+            enemy->specialAbility--;
+        }
+        else {
+            move->LSPflag = true;
+            enemy->specialAbility = 10; // resetting the move timer
+        }
+    }
+}
+
+void updateTrapperEnemy(EnemyFrame* frame, Enemy* enemy, EnemyMove* move) {
+    if (enemy->specialAbility > 0) {
+        enemy->specialAbility--;
+    }
+    else {
+        // movement behavior is the same as the braindead enemy
+        if (matchesPosition(enemy->playerLSP, INVALID_POS)) {
+            roamToUnvisited(enemy, *frame->grid);
+
+            // chance to set a bomb every time the random location is reached
+            setBomb(frame->bombHead, move->newPos, frame->grid->itemLayer, frame->bombSpawnChance);
+        }
+        enemy->specialAbility = frame->trapperInterval;
+        move->LSPflag = true;
+    }
+
+    // sleep until the frame the trapper moves again
+    move->wakeDelay = skipCountdown(enemy, 0);
+}
+
+void updateBurstEnemy(EnemyFrame* frame, Enemy* enemy, EnemyMove* move) {
+    AllEntities* grid = frame->grid;
+    Position oldPos = enemy->pos;
+
+    // after maxTime frames pass, the enemy will pursue the player indefinitely while permanently skipping the passive phase
+    if (frame->burstInterval < 0) {
+        enemy->playerLSP = frame->player.pos;
+    }
+
+    // only have the enemy move when it is aggro'd (therefore, it is only active when aggro'd)
+    if (enemy->isAggro) {
+        move->LSPflag = true;
+        move->wakeDelay = 1;
+        return;
+    }
+
+    // travel phase: the enemy beelines straight for the player's exact location.
+    //      -- it is important to note that this enemy will always keep moving until the LSP is reached
+    if (enemy->specialAbility > 0) {
+        enemy->specialAbility--;
+
+        // flicker for 10 frames to indicate burst movement is happening soon
+        if (enemy->specialAbility <= 10) {
+            grid->playerLayer[oldPos.y][oldPos.x] = (frame->frameCounter % 2 == 0) ? passiveEnemyMarkers[BURST_ENEMY] : aggroEnemyMarkers[BURST_ENEMY];
+        }
+        else {
+            grid->playerLayer[oldPos.y][oldPos.x] = enemy->passiveMarker;
+        }
+    }
+    else { // passive phase: sits still for a decreasingly short interval
+
+        // target the player's exact location
+        enemy->playerLSP = frame->player.pos;
+
+        // activating the burst enemy once the interval is done
+        enemy->isAggro = true;
+
+        // resetting the interval to a shorter one
+        enemy->specialAbility = frame->burstInterval;
+        move->wakeDelay = 1;
+        return;
+    }
+
+    // sleep thru the passive phase until the countdown is one frame away from flickering
+    move->wakeDelay = skipCountdown(enemy, 11);
+}
+
+void updateShooterEnemy(EnemyFrame* frame, Enemy* enemy, EnemyMove* move) {
+
+    // switch to aggro behavior if the shooter sees the player
+    if (move->seesPlayer) {
+        enemy->isAggro = true;
+        enemy->playerLSP = frame->player.pos;
+
+        if (frame->frameCounter % 10 == 0) {
+            move->LSPflag = true;
+        }
+
+        if (enemy->specialAbility > 0) {
+            enemy->specialAbility--;
+        }
+        else {
+            enemy->specialAbility = 0;
+            move->isBullet = true;
+        }
+    }
+    else { // define the enemy's passive behavior
+
+        // find another position to roam to if the current one is already reached
+        if (matchesPosition(enemy->playerLSP, INVALID_POS)) {
+            roamToUnvisited(enemy, *frame->grid);
+            enemy->specialAbility = 0;
+        }
+
+        // move only every 20 frames
+        if (frame->frameCounter % 20 == 0) {
+            move->LSPflag = true;
+        }
+    }
+}
+
+void updateIdleEnemy(EnemyFrame* frame, Enemy* enemy, EnemyMove* move) {
+
+    // enemy types that are parsed from level files but don't have a behavior yet stay where they are, so they never need to wake again
+    move->wakeDelay = 0;
+}
+
+void finishEnemyMove(EnemyFrame* frame, Enemy* enemy, EnemyMove* move) {
+    AllEntities* grid = frame->grid;
+    const Position oldPos = enemy->pos;
+    Position newPos = move->newPos;
 
-            // validate the new position before finalizing the move
-            if (isValid(*grid, newPos, 'e')) {
+    if (move->LSPflag) {
 
-                // update the enemy's position to the new one
-                allEnemies[i][j].pos = newPos;
+        // move to the player's LSP if known
+        if (!matchesPosition(enemy->playerLSP, INVALID_POS)) {
 
-                // clear the enemy's old position from the player grid
-                grid->playerLayer[oldPos.y][oldPos.x] = ' ';
+            /* on a level whose walls never change, the next step is looked up in the next-hop table, and an enemy
+                headed for the player's current position steps down the distance map around the player. otherwise (or if
+                another enemy is in the way) keep following the cached path while it still leads to the LSP, or ask for
+                a new one, which is searched right away if this frame's budget allows. until it arrives, the enemy keeps
+                walking its old path, or holds position if that's blocked too. */
+            if (!followNextHop(enemy, *grid, &newPos) && !stepTowardPlayer(enemy, *grid, frame->player.pos, &newPos) &&
+                (!isCachedPathCurrent(enemy, *grid) || !followCachedPath(enemy, *grid, &newPos))) {
+                requestEnemyPath(grid->navMap, enemy);
+                servicePathRequests(*grid);
+
+                if (!followCachedPath(enemy, *grid, &newPos)) {
+                    newPos = oldPos;
+                }
+            }
 
-                // mark the enemy's new position with its appropriate marker depending on its aggro state
-                grid->playerLayer[newPos.y][newPos.x] = allEnemies[i][j].isAggro ? allEnemies[i][j].aggroMarker : allEnemies[i][j].passiveMarker;
+            // set the LSP to an invalid location once reached then de-aggro the enemy
+            if (matchesPosition(enemy->pos, enemy->playerLSP)) {
+                enemy->playerLSP = INVALID_POS;
+                enemy->isAggro = false;
             }
         }
-    }    
+        else { // if LSP is unknown, make a random move instead
+            makeRandomMove(*grid, &newPos, oldPos);
+            enemy->isAggro = false;
+        }
+    }
+
+    if (move->isBullet && move->LSPflag) {
+        int a = findBulletDirection(oldPos, newPos);
+
+        *frame->bulletHead = shootBullet(*frame->bulletHead, enemy->pos, a);
+    }
+
+    // validate the new position before finalizing the move
+    if (isValid(*grid, newPos, 'e')) {
+
+        // update the enemy's position to the new one
+        enemy->pos = newPos;
+
+        // clear the enemy's old position from the player grid
+        grid->playerLayer[oldPos.y][oldPos.x] = ' ';
+
+        // mark the enemy's new position with its appropriate marker depending on its aggro state
+        grid->playerLayer[newPos.y][newPos.x] = enemy->isAggro ? enemy->aggroMarker : enemy->passiveMarker;
+    }
 }
 
 void updateBullets(Bullet** head, Particle** explosionHead, AllEntities* grid) {
@@ -1074,8 +2951,8 @@ void updateBullets(Bullet** head, Particle** explosionHead, AllEntities* grid) {
             }
 
             // if the bullet strikes some wall within the grid, clear it
-            if (newPos.x >= 1 && newPos.x < GRID_SIZE - 1 && newPos.y >= 1 && newPos.y < GRID_SIZE - 1) {
-                grid->wallLayer[newPos.y][newPos.x] = ' ';
+            if (newPos.x >= 1 && newPos.x < grid->width - 1 && newPos.y >= 1 && newPos.y < grid->height - 1) {
+                clearWall(grid, newPos);
 
                 // have an explosion particle replace the wall for 5 frames
                 *explosionHead = addNewParticle(*explosionHead, newPos, '#', 5);
@@ -1127,7 +3004,7 @@ int findBulletDirection(Position old, Position new) {
     return 9999;
 }
 
-void detonateBomb(Particle** explosionHead, Position pos, int blastRadius, unsigned char** itemLayer, unsigned char** wallLayer) {
+void detonateBomb(Particle** explosionHead, Position pos, int blastRadius, AllEntities* grid) {
 
     // preparing to clear all surrounding cells by defining the bounds to clear
     int startX = pos.x - blastRadius;
@@ -1138,8 +3015,8 @@ void detonateBomb(Particle** explosionHead, Position pos, int blastRadius, unsig
     // clear all surrounding spaces except the walls along the edges of the game board
     for (int x = startX; x <= endX; x++) {
         for (int y = startY; y <= endY; y++) {
-            if (x >= 1 && x < GRID_SIZE - 1 && y >= 1 && y < GRID_SIZE - 1) {
-                wallLayer[y][x] = ' '; // clear the wall
+            if (x >= 1 && x < grid->width - 1 && y >= 1 && y < grid->height - 1) {
+                clearWall(grid, (Position) { x, y }); // clear the wall
 
                 // add a new explosion particle that will last for half a second
                 *explosionHead = addNewParticle(*explosionHead, (Position) { x, y }, '#', FPS / 2);
@@ -1164,20 +3041,20 @@ void displayBombFlicker(Particle* bombHead, unsigned char** itemLayer, int frame
     }
 }
 
-void updateAllParticles(Particle** bombHead, Particle** explosionHead, unsigned char** itemLayer, unsigned char** wallLayer, int frameCounter) {
+void updateAllParticles(Particle** bombHead, Particle** explosionHead, AllEntities* grid, int frameCounter) {
     
     // update the linked list of bomb particles:
     // the explosionHead has to be passed in so that explosion particles can be added upon any bomb detonations
-    updateParticleType(bombHead, explosionHead, itemLayer, wallLayer, frameCounter);
+    updateParticleType(bombHead, explosionHead, grid, frameCounter);
 
     // as for updating all other particle types, the extra explosionHead argument is just passed in as NULL
-    updateParticleType(explosionHead, NULL, itemLayer, wallLayer, frameCounter);
+    updateParticleType(explosionHead, NULL, grid, frameCounter);
 
     // have all bombs flicker between 'O' and '0' on their final second before detonating
-    displayBombFlicker(*bombHead, itemLayer, frameCounter);
+    displayBombFlicker(*bombHead, grid->itemLayer, frameCounter);
 }
 
-void updateParticleType(Particle** typeHead, Particle** explosionHead, unsigned char** itemLayer, unsigned char** wallLayer, int frameCounter) {
+void updateParticleType(Particle** typeHead, Particle** explosionHead, AllEntities* grid, int frameCounter) {
     
     /* all particles are defined to be items, therefore they will be stored in the itemLayer */
     
@@ -1193,7 +3070,7 @@ void updateParticleType(Particle** typeHead, Particle** explosionHead, unsigned
 
         // delete the particle node if its timer is up
         if (current->timer <= 0) {
-            itemLayer[current->pos.y][current->pos.x] = ' '; // clear it from the grid
+            grid->itemLayer[current->pos.y][current->pos.x] = ' '; // clear it from the grid
 
             // unlink the node from the list
             if (prev == NULL) {
@@ -1205,7 +3082,7 @@ void updateParticleType(Particle** typeHead, Particle** explosionHead, unsigned
  
             // if the particle type is a bomb, detonate it to add its explosion particles
             if (isTypeBomb) {
-                detonateBomb(explosionHead, current->pos, 1, itemLayer, wallLayer);
+                detonateBomb(explosionHead, current->pos, 1, grid);
             }
 
             // free the node using a temp pointer
@@ -1221,10 +3098,10 @@ void updateParticleType(Particle** typeHead, Particle** explosionHead, unsigned
 
             // if the bomb list being updated, then mark each bomb according to its countdown
             if (isTypeBomb) {
-                itemLayer[current->pos.y][current->pos.x] = timebombMarkers[current->timer / FPS];
+                grid->itemLayer[current->pos.y][current->pos.x] = timebombMarkers[current->timer / FPS];
             }
             else { // for all other particle types, just print the particle's marker
-                itemLayer[current->pos.y][current->pos.x] = current->marker;
+                grid->itemLayer[current->pos.y][current->pos.x] = current->marker;
             }
 
             prev = current;
@@ -1291,9 +3168,9 @@ bool canMove(Position pos, AllEntities grid) {
 }
 
 void roamToUnvisited(Enemy* enemy, AllEntities grid) {
-    Position path[NUM_SQUARES];
-    int pathLength = 0;
     int shuffleCounter = 0;
+    Position firstStep;
+    bool hasTable = grid.navMap->nextHops != NULL;
 
     // check each adjacent space to see if the enemy can even move at all
     if (!canMove(enemy->pos, grid)) {
@@ -1301,27 +3178,140 @@ void roamToUnvisited(Enemy* enemy, AllEntities grid) {
         return;
     }
 
+    // without a next-hop table, a flood fill of the enemy's area says which roam locations can be reached at all
+    if (!hasTable) {
+        findReachableArea(grid, enemy->pos);
+    }
+
     do { // select a new position to roam to as long as it has a valid path to and is valid itself
 
-        // reset the index to 0 if all positions have been iterated thru, then re-shuffle to prevent the same roam order from occurring
-        if (enemy->roamIndex >= NUM_SQUARES) {
+        // reset the index to 0 if all positions have been iterated thru, then pick a new order to prevent the same roam order from occurring
+        if (enemy->roamIndex >= grid.roamCount) {
             enemy->roamIndex = 0;
-            shuffleArr(enemy->roamArr, NUM_SQUARES);
+            pickRoamOrder(enemy, grid.roamCount);
             shuffleCounter++;
         }
 
-        /* any enemy should never have to shuffle the roam array more than once since every position on the grid will eventually be checked. 
-            by checking if the roam array has been shuffled more than once, the loop will eventually terminate. */
+        /* any enemy should never have to pick a new roam order more than once since every position on the grid will eventually be checked.
+            by checking if a new order has been picked more than once, the loop will eventually terminate. */
         if (shuffleCounter > 1) {
             enemy->playerLSP = INVALID_POS;
             break;
         }
 
         // assign the new position to the enemy's LSP of the player, then increment the roamIndex to identify the next roaming position
-        enemy->playerLSP = enemy->roamArr[enemy->roamIndex];
+        enemy->playerLSP = grid.roamArr[(enemy->roamStart + (long long)enemy->roamIndex * enemy->roamStride) % grid.roamCount];
         enemy->roamIndex++;
 
-    } while (!findPath(grid, enemy->pos, enemy->playerLSP, path, &pathLength) || !isValid(grid, enemy->playerLSP, 'e'));
+    } while (!isValid(grid, enemy->playerLSP, 'e') ||
+        (hasTable ? !findNextHop(grid, enemy->pos, enemy->playerLSP, &firstStep) : !testBit(&grid.navMap->area, enemy->playerLSP)));
+
+    /* unreachable locations were already skipped above. with a next-hop table, each step is looked up as the enemy
+        moves. otherwise the path is searched as a request rather than here, so picking a roam location never blows
+        the frame's budget. if other enemies block the way, the request fails and this is called again for the next one. */
+    if (!matchesPosition(enemy->playerLSP, INVALID_POS) && !hasTable) {
+        requestEnemyPath(grid.navMap, enemy);
+    }
+}
+
+void cachePath(Enemy* enemy, Position* path, int pathLength, unsigned int wallVersion) {
+
+    // only grow the cache, since paths on the same board tend to stay around the same length
+    if (pathLength > enemy->cachedPathCapacity) {
+        Position* newCache = realloc(enemy->cachedPath, sizeof(Position) * pathLength);
+        if (newCache == NULL) { // without a cache the enemy just searches again on every move
+            enemy->cachedPathLength = 0;
+            return;
+        }
+        enemy->cachedPath = newCache;
+        enemy->cachedPathCapacity = pathLength;
+    }
+
+    memcpy(enemy->cachedPath, path, sizeof(Position) * pathLength);
+    enemy->cachedPathLength = pathLength;
+    enemy->cachedPathIndex = 0;
+    enemy->cachedTarget = path[pathLength - 1];
+    enemy->cachedWallVersion = wallVersion;
+}
+
+bool isCachedPathCurrent(Enemy* enemy, AllEntities grid) {
+
+    // the cache is stale if there isn't one, the target has moved, or a wall has been destroyed since it was found
+    return enemy->cachedPathLength > 0 && matchesPosition(enemy->cachedTarget, enemy->playerLSP) && enemy->cachedWallVersion == grid.navMap->wallVersion;
+}
+
+bool followCachedPath(Enemy* enemy, AllEntities grid, Position* newPos) {
+    Position* path = enemy->cachedPath;
+    int index = enemy->cachedPathIndex;
+
+    if (enemy->cachedPathLength == 0) {
+        return false;
+    }
+
+    // advance along the path if the enemy took the step it was given last time
+    if (index + 1 < enemy->cachedPathLength && matchesPosition(path[index + 1], enemy->pos)) {
+        index++;
+    }
+
+    // re-plan if the enemy ended up off its path
+    if (!matchesPosition(path[index], enemy->pos)) {
+        return false;
+    }
+    enemy->cachedPathIndex = index;
+
+    // stay put once the end of the path is reached, just like a fresh path of length 1
+    if (index + 1 == enemy->cachedPathLength) {
+        *newPos = enemy->pos;
+        return true;
+    }
+
+    // re-plan if the next step has been blocked since the path was found
+    if (!isValid(grid, path[index + 1], 'e')) {
+        return false;
+    }
+
+    *newPos = path[index + 1];
+    return true;
+}
+
+// the table only knows about walls, so a step onto another enemy is left for the search to find a way around
+bool followNextHop(Enemy* enemy, AllEntities grid, Position* newPos) {
+    Position next;
+    if (!findNextHop(grid, enemy->pos, enemy->playerLSP, &next)) {
+        return false;
+    }
+    if (!matchesPosition(next, enemy->pos) && !isValid(grid, next, 'e')) {
+        return false;
+    }
+    *newPos = next;
+    return true;
+}
+
+/* while the enemy is headed for where the player is right now, any neighbor one step closer in the distance map is
+    the next step of a shortest path, so the enemy can walk downhill without a search. the map only knows about walls,
+    so if every such step is blocked by another enemy, the search is left to find a way around. */
+bool stepTowardPlayer(Enemy* enemy, AllEntities grid, Position player, Position* newPos) {
+    if (!matchesPosition(enemy->playerLSP, player)) {
+        return false;
+    }
+
+    int distance = findPlayerDistance(grid, player, enemy->pos);
+    if (distance < 0) {
+        return false;
+    }
+    if (distance == 0) {
+        *newPos = enemy->pos;
+        return true;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        Position neighbor = { enemy->pos.x + dx[i], enemy->pos.y + dy[i] };
+        if (isValid(grid, neighbor, 'e') && findPlayerDistance(grid, player, neighbor) == distance - 1) {
+            *newPos = neighbor;
+            return true;
+        }
+    }
+    return false;
 }
 
 bool matchesPosition(Position a, Position b) {
@@ -1458,7 +3448,7 @@ bool gameLoop(Level* level, GameBoard* gameElements) {
         }
 
         // updates the countdown timers of all particles (bombs included) as well as their display state on the grid
-        updateAllParticles(&allBombs, &allExplosions, gameElements->grid.itemLayer, gameElements->grid.wallLayer, frameCounter);
+        updateAllParticles(&allBombs, &allExplosions, &gameElements->grid, frameCounter);
 
         updateBullets(&allBullets, &allExplosions, &gameElements->grid);
 
@@ -1468,7 +3458,7 @@ bool gameLoop(Level* level, GameBoard* gameElements) {
         // redraw the game every frame to show the updated positions of all entities
         drawGameState(gameElements->grid, *level);
 
-        moveAllEnemies(frameCounter, *level, &gameElements->grid, gameElements->allEnemies, gameElements->player, &allBombs, &allBullets);
+        moveAllEnemies(frameCounter, &gameElements->grid, gameElements->allEnemies, gameElements->scheduler, gameElements->player, &allBombs, &allBullets);
 
         // game-ending conditions: either the player completes the game objective or gets caught by an enemy
         if (gameWin(*level, gameElements->player.pos)) {
@@ -1544,36 +3534,40 @@ bool gameLose(Level level, GameBoard game, Particle* explosionHead) {
     return false;
 }
 
-unsigned char** initializeGrid() {
+unsigned char** initializeGrid(int width, int height) {
 
-    // allocate memory for the grid
-    unsigned char** grid = malloc(GRID_SIZE * sizeof(char*));
-    if (grid != NULL) {
-        for (int i = 0; i < GRID_SIZE; i++) {
-            grid[i] = malloc(GRID_SIZE * sizeof(char));
-            if (grid[i] == NULL) {
-                fprintf(stderr, "\nMALLOC ERROR: Memory allocation to initialize the starting grid failed!\n");
-                for (int j = 0; j < i; j++) {
-                    free(grid[j]);
-                }
-                free(grid);
-                return NULL;
-            }
-        }
+    // allocate memory for the row pointers, then for all of the cells at once so the layer stays contiguous
+    unsigned char** grid = malloc(height * sizeof(char*));
+    if (grid == NULL) {
+        fprintf(stderr, "\nMALLOC ERROR: Memory allocation to initialize the starting grid failed!\n");
+        return NULL;
     }
-    else {
+
+    unsigned char* cells = malloc((width * height + GATHER_PADDING) * sizeof(char));
+    if (cells == NULL) {
         fprintf(stderr, "\nMALLOC ERROR: Memory allocation to initialize the starting grid failed!\n");
+        free(grid);
         return NULL;
     }
 
-    // initially set each layer's entire grid as empty spaces
-    for (int i = 0; i < GRID_SIZE; i++) {
-        memset(grid[i], ' ', GRID_SIZE);
+    // point each row into the block of cells
+    for (int i = 0; i < height; i++) {
+        grid[i] = cells + i * width;
     }
 
+    // initially set each layer's entire grid (and the padding after it) as empty spaces
+    memset(cells, ' ', width * height + GATHER_PADDING);
+
     return grid;
 }
 
+void freeGrid(unsigned char** grid) {
+    if (grid == NULL) return;
+
+    free(grid[0]); // the first row points to the start of the block holding every cell
+    free(grid);
+}
+
 Position** initializeAllItems(Level level, unsigned char** itemLayer) {
 
     // allocate memory for each item type, also accounting for the number of items for each item type
@@ -1617,9 +3611,15 @@ GameBoard initializeGameBoard(Level level, bool isLevel) {
     GameBoard newBoard;
 
     // initialize each entity layer as a blank grid
-    newBoard.grid.playerLayer = initializeGrid();
-    newBoard.grid.wallLayer = initializeGrid();
-    newBoard.grid.itemLayer = initializeGrid();
+    newBoard.grid.playerLayer = initializeGrid(level.width, level.height);
+    newBoard.grid.wallLayer = initializeGrid(level.width, level.height);
+    newBoard.grid.itemLayer = initializeGrid(level.width, level.height);
+    newBoard.grid.width = level.width;
+    newBoard.grid.height = level.height;
+    newBoard.grid.roamArr = NULL;
+    newBoard.grid.navMap = NULL;
+    newBoard.grid.workers = NULL;
+    newBoard.scheduler = NULL;
 
     // ensure that memory allocation for each grid was successful
     if (newBoard.grid.playerLayer == NULL) {
@@ -1632,7 +3632,11 @@ GameBoard initializeGameBoard(Level level, bool isLevel) {
         newBoard.hasError = MALLOC_ITEM_LAYER_FAILED;
     }
     else { // finalize layer initialization by copying data from the level struct to the appropriate layer
-        newBoard.allEnemies = initializeAllEnemies(level, newBoard.grid.playerLayer);
+
+        // every enemy roams over the same table of positions, each in its own order, so the table is only built once per board
+        newBoard.grid.roamArr = malloc(sizeof(Position) * (level.width - 3) * (level.height - 3));
+        newBoard.grid.roamCount = (newBoard.grid.roamArr != NULL) ? initializeRoamArr(newBoard.grid.roamArr, level.width, level.height) : 0;
+        newBoard.allEnemies = (newBoard.grid.roamArr != NULL) ? initializeAllEnemies(level, newBoard.grid.playerLayer, newBoard.grid.roamCount) : NULL;
         newBoard.allItems = initializeAllItems(level, newBoard.grid.itemLayer);
 
         // ensure that memory allocation for both arrays was successful
@@ -1655,6 +3659,30 @@ GameBoard initializeGameBoard(Level level, bool isLevel) {
             if (isLevel) {
                 newBoard.grid.playerLayer[level.start.y][level.start.x] = 'X'; // mark the player's starting location
                 newBoard.grid.wallLayer[level.end.y][level.end.x] = 'E'; // mark the exit
+
+                // size the pathfinding buffers to the board (large boards also get a cluster graph for hierarchical pathfinding)
+                newBoard.grid.navMap = createNavigationMap(level.width, level.height);
+                if (newBoard.grid.navMap == NULL) {
+                    newBoard.hasError = MALLOC_NAVIGATION_MAP_FAILED;
+                }
+                else {
+                    fillOpenBitboard(newBoard.grid);
+
+                    // put every enemy on the timer wheel for its first move
+                    newBoard.scheduler = createEnemyScheduler(level, newBoard.allEnemies);
+                    if (newBoard.scheduler == NULL) {
+                        newBoard.hasError = MALLOC_ENEMY_SCHEDULER_FAILED;
+                    }
+
+                    // the planning phase still works without the thread pool, just on one thread, so failing to create it isn't an error
+                    newBoard.grid.workers = createWorkerPool();
+
+                    // trappers' bombs and shooters' bullets are the only things that destroy walls, so without them every
+                    // enemy path can be looked up instead of searched (the searches still work if the table can't be built)
+                    if (level.enemyCounts[TRAPPER_ENEMY] == 0 && level.enemyCounts[SHOOTER_ENEMY] == 0) {
+                        buildNextHopTable(newBoard.grid);
+                    }
+                }
             }
         }
     }
@@ -1676,16 +3704,17 @@ Player initializePlayer(Level level) {
     return newPlayer;
 }
 
-void initializeRoamArr(Position* roamArr) {
+int initializeRoamArr(Position* roamArr, int width, int height) {
     int index = 0;
 
     // initialize each index of the array to be every possible position on the grid
-    for (int i = 1; i < GRID_SIZE - 2; i++) {
-        for (int j = 1; j < GRID_SIZE - 2; j++) {
+    for (int i = 1; i < width - 2; i++) {
+        for (int j = 1; j < height - 2; j++) {
             roamArr[index++] = (Position){ i, j };
         }
     }
     shuffleArr(roamArr, index); // shuffle the array to randomize the roaming order of the positions
+    return index;
 }
 
 void shuffleArr(Position* roamArr, int size) {
@@ -1707,11 +3736,30 @@ void shuffleArr(Position* roamArr, int size) {
     }
 }
 
-Enemy initializeEnemy(unsigned char** playerLayer, Position newPos, char passiveMarker, char aggroMarker, int moveInterval) {
+void pickRoamOrder(Enemy* enemy, int roamCount) {
+
+    /* the roam table is shared, so instead of shuffling it, each enemy walks it from a random start in random sized steps.
+        a step that shares no factor with the table's size lands on every position exactly once before coming back around. */
+    enemy->roamStart = rand() % roamCount;
+    int stride, a, b;
+    do {
+        stride = 1 + rand() % roamCount;
+        a = stride;
+        b = roamCount;
+        while (b != 0) { // the greatest common divisor of the step and the table size
+            int remainder = a % b;
+            a = b;
+            b = remainder;
+        }
+    } while (a != 1);
+    enemy->roamStride = stride;
+}
+
+Enemy initializeEnemy(unsigned char** playerLayer, Position newPos, char passiveMarker, char aggroMarker, int moveInterval, SearchType searchType, int roamCount) {
     Enemy newEnemy;
 
     // initializing the passive roaming mechanics of the enemy
-    initializeRoamArr(newEnemy.roamArr);
+    pickRoamOrder(&newEnemy, roamCount);
     newEnemy.roamIndex = 0;
 
     newEnemy.pos = newPos; // determine the enemy's starting position according to the data stored in the level struct
@@ -1719,6 +3767,13 @@ Enemy initializeEnemy(unsigned char** playerLayer, Position newPos, char passive
 
     playerLayer[newPos.y][newPos.x] = passiveMarker; // place the enemy on the grid in its initial passive state
     newEnemy.moveInterval = moveInterval; // amount of frames that pass before the enemy moves again
+    newEnemy.searchType = searchType;
+    newEnemy.cachedPath = NULL; // allocated on the first path the enemy finds
+    newEnemy.cachedPathLength = 0;
+    newEnemy.cachedPathCapacity = 0;
+    newEnemy.cachedPathIndex = 0;
+    newEnemy.cachedTarget = INVALID_POS;
+    newEnemy.cachedWallVersion = 0;
     newEnemy.aggroMarker = aggroMarker;
     newEnemy.passiveMarker = passiveMarker;
 
@@ -1729,7 +3784,7 @@ Enemy initializeEnemy(unsigned char** playerLayer, Position newPos, char passive
     return newEnemy;
 }
 
-Enemy** initializeAllEnemies(Level level, unsigned char** playerLayer) {
+Enemy** initializeAllEnemies(Level level, unsigned char** playerLayer, int roamCount) {
 
     // allocate memory for all enemy types
     Enemy** allEnemies = malloc(sizeof(Enemy*) * NUM_ENEMY_TYPES);
@@ -1758,26 +3813,34 @@ Enemy** initializeAllEnemies(Level level, unsigned char** playerLayer) {
     for (int i = 0; i < NUM_ENEMY_TYPES; i++) {
         if (level.enemyCounts[i] == 0) continue;
         for (int j = 0; j < level.enemyCounts[i]; j++) {            
-            allEnemies[i][j] = initializeEnemy(playerLayer, level.allEnemies[i][j], passiveEnemyMarkers[i], aggroEnemyMarkers[i], moveIntervals[i]);
+            allEnemies[i][j] = initializeEnemy(playerLayer, level.allEnemies[i][j], passiveEnemyMarkers[i], aggroEnemyMarkers[i], moveIntervals[i], enemySearchTypes[i], roamCount);
         }
     }
     return allEnemies;
 }
 
-void freeGameBoard(GameBoard* gameElements) {
-    for (int i = 0; i < GRID_SIZE; i++) {
-        free(gameElements->grid.playerLayer[i]);
-        free(gameElements->grid.wallLayer[i]);
-        free(gameElements->grid.itemLayer[i]);
-    }
-    free(gameElements->grid.playerLayer);
-    free(gameElements->grid.wallLayer);
-    free(gameElements->grid.itemLayer);
+void freeAllEnemies(Level level, Enemy** allEnemies) {
+    if (allEnemies == NULL) return;
 
     for (int i = 0; i < NUM_ENEMY_TYPES; i++) {
-        free(gameElements->allEnemies[i]);
+        for (int j = 0; j < level.enemyCounts[i]; j++) {
+            free(allEnemies[i][j].cachedPath);
+        }
+        free(allEnemies[i]);
     }
-    free(gameElements->allEnemies);
+    free(allEnemies);
+}
+
+void freeGameBoard(Level level, GameBoard* gameElements) {
+    freeGrid(gameElements->grid.playerLayer);
+    freeGrid(gameElements->grid.wallLayer);
+    freeGrid(gameElements->grid.itemLayer);
+    free(gameElements->grid.roamArr);
+    freeNavigationMap(gameElements->grid.navMap);
+    freeEnemyScheduler(gameElements->scheduler);
+    freeWorkerPool(gameElements->grid.workers);
+
+    freeAllEnemies(level, gameElements->allEnemies);
 
     for (int i = 0; i < NUM_ITEM_TYPES; i++) {
         free(gameElements->allItems[i]);
@@ -1785,157 +3848,408 @@ void freeGameBoard(GameBoard* gameElements) {
     free(gameElements->allItems);
 }
 
+bool readLevelHeader(FILE* levelFile, int* width, int* height) {
+    char header[64];
+
+    /* a level file may start with a "width height" line. the first row of a board is always a wall,
+        so any file whose first line isn't a pair of numbers is an older GRID_SIZE x GRID_SIZE level. */
+    if (fgets(header, sizeof(header), levelFile) != NULL && sscanf(header, "%d %d", width, height) == 2) {
+        return true;
+    }
+
+    // no header: go back to the first row and use the default board size
+    *width = GRID_SIZE;
+    *height = GRID_SIZE;
+    rewind(levelFile);
+    return false;
+}
+
 Level parseLevelLayout(const char* fileName) {
-    Level newLevel = initializeLevel();
+
+    // opening the file to parse, then reading the board dimensions before anything is allocated
+    FILE* levelFile = fopen(fileName, "r");
+    int width = GRID_SIZE, height = GRID_SIZE;
+    bool isValidSize = true;
+    if (levelFile != NULL) {
+        readLevelHeader(levelFile, &width, &height);
+
+#ifdef FIXED_GRID_SIZE
+        isValidSize = (width == GRID_SIZE && height == GRID_SIZE);
+#else
+        isValidSize = (width >= MIN_BOARD_SIZE && width <= MAX_BOARD_SIZE && height >= MIN_BOARD_SIZE && height <= MAX_BOARD_SIZE);
+#endif
+        if (!isValidSize) {
+            width = GRID_SIZE;
+            height = GRID_SIZE;
+        }
+    }
+
+    /* the arrays are still allocated when the file can't be used so that the level can be freed the same way
+        as any other. the default size is used in that case since the dimensions from the file can't be trusted. */
+    Level newLevel = initializeLevel(width, height);
     if (newLevel.hasError) {
+        if (levelFile != NULL) fclose(levelFile);
         return newLevel;
     }
 
-    // opening the file to parse
-    FILE* levelFile = fopen(fileName, "r");
     if (levelFile == NULL) {
         newLevel.hasError = ERROR_OPENING_FILE;
         return newLevel;
     }
+    else if (!isValidSize) {
+        newLevel.hasError = INVALID_LEVEL_SIZE;
+        fclose(levelFile);
+        return newLevel;
+    }
 
     // initialize the starting and ending locations to invalid positions beforehand for error checking
     newLevel.start = INVALID_POS;
     newLevel.end = INVALID_POS;
 
     // file parsing: using x- and y-coordinates to correspond with each row and column location in the text file
-    char line[GRID_SIZE + 2]; // +2 for null-terminating and newline chars
-    bool unknownEnemyFlag = false;
-    for (int y = 0; fgets(line, sizeof(line), levelFile) != NULL; y++) {
-        for (int x = 0; x < GRID_SIZE; x++) {
-            Position currentPos = (Position){ x, y };
-
-            // matching each char in the text file with its corresponding entity,
-            // then storing each entity's location in its corresponding array while keeping count of each entity type
-            switch (line[x]) {
-            case ' ': // ignore all empty spaces
-                break;
-            case 'X': // setting the starting location
-                newLevel.start = currentPos;
-                break;
-            case 'E': // setting the location objective
-                newLevel.end = currentPos;
-                break;
-            case '#': // storing the location of each wall
-                newLevel.walls[newLevel.wallCount++] = currentPos;
-                break;
-            case 'B':
-                newLevel.allEnemies[BASIC_ENEMY][newLevel.enemyCounts[BASIC_ENEMY]++] = currentPos;
-                break;
-            case 'P':
-                newLevel.allEnemies[PATROL_ENEMY][newLevel.enemyCounts[PATROL_ENEMY]++] = currentPos;
-                break;
-            case 't': // lowercase t: teleporter enemy
-                newLevel.allEnemies[TELEPORT_ENEMY][newLevel.enemyCounts[TELEPORT_ENEMY]++] = currentPos;
-                break;
-            case 'C':
-                newLevel.allEnemies[CHASER_ENEMY][newLevel.enemyCounts[CHASER_ENEMY]++] = currentPos;
-                break;
-            case 'T': // uppercase T: bombper enemy
-                newLevel.allEnemies[TRAPPER_ENEMY][newLevel.enemyCounts[TRAPPER_ENEMY]++] = currentPos;
-                break;
-            case 's': // lowercase s: burst enemy
-                newLevel.allEnemies[BURST_ENEMY][newLevel.enemyCounts[BURST_ENEMY]++] = currentPos;
-                break;
-            case 'M':
-                newLevel.allEnemies[MIMIC_ENEMY][newLevel.enemyCounts[MIMIC_ENEMY]++] = currentPos;
-                break;
-            case 'W':
-                newLevel.allEnemies[WALL_BREAKER_ENEMY][newLevel.enemyCounts[WALL_BREAKER_ENEMY]++] = currentPos;
-                break;
-            case 'S': // uppercase S: shooter enemy
-                newLevel.allEnemies[SHOOTER_ENEMY][newLevel.enemyCounts[SHOOTER_ENEMY]++] = currentPos;
-                break;
-            case '!':
-                newLevel.allItems[OBJ_ITEM][newLevel.itemCounts[OBJ_ITEM]++] = currentPos;
-                break;
-            default: // immediately return an error upon encountering an unidentified entity type
-                newLevel.hasError = UNKNOWN_ENEMY_TYPE;
-                fclose(levelFile);
-                return newLevel;
-            }
-        }
+    int lineSize = newLevel.width + 3; // +3 for the carriage return, newline, and null-terminating chars
+    char* line = malloc(lineSize);
+    if (line == NULL) {
+        newLevel.hasError = MALLOC_WALL_POSITION_FAILED;
+        fclose(levelFile);
+        return newLevel;
     }
 
-    // finish initialization only if both the valid start and end positions have been identified
-    if (matchesPosition(newLevel.start, INVALID_POS)) {
-        newLevel.hasError = NO_PLAYER_EXISTS;
-    }
-    else if (matchesPosition(newLevel.end, INVALID_POS)) {
-        newLevel.hasError = NO_EXIT_EXISTS;
-    }
-    else {
-        // shrinking the wall positions array to avoid memory wastage
-        Position* temp = realloc(newLevel.walls, sizeof(Position) * newLevel.wallCount);
-        if (temp == NULL) {
-            newLevel.hasError = REALLOC_WALL_POSITION_FAILED;
+    /* the rows are read twice: first to count every entity type, then, once each array has been allocated at
+        exactly that size, to store their positions. the second pass starts back at the first row, after any header. */
+    long firstRow = ftell(levelFile);
+    for (int pass = 0; pass < 2; pass++) {
+        bool isStoring = (pass == 1);
+        if (isStoring && (!allocateLevelArrays(&newLevel) || fseek(levelFile, firstRow, SEEK_SET) != 0)) {
+            if (!newLevel.hasError) newLevel.hasError = ERROR_OPENING_FILE;
+            free(line);
             fclose(levelFile);
             return newLevel;
         }
-        newLevel.walls = temp;
 
-        // reallocate memory for the array of each enemy type
-        for (int i = 0; i < NUM_ENEMY_TYPES; i++) {
+        for (int y = 0; y < newLevel.height && fgets(line, lineSize, levelFile) != NULL; y++) {
+            for (int x = 0; x < newLevel.width; x++) {
+                Position currentPos = (Position){ x, y };
+                Position* positions = NULL;
+                int* count = NULL;
 
-            // if there are no enemies of that enemy type, then free the array storing that type
-            if (newLevel.enemyCounts[i] == 0) {
-                free(newLevel.allEnemies[i]);
-                newLevel.allEnemies[i] = NULL;
-            }
-            else { // otherwise, shrink the array to store only the updated count of that type
-                Position* temp = realloc(newLevel.allEnemies[i], sizeof(Position) * newLevel.enemyCounts[i]);
-                if (temp == NULL) {
-                    newLevel.hasError = REALLOC_ENEMY_COUNT_FAILED;
+                // matching each char in the text file with its corresponding entity, then finding the array
+                // that entity's location is stored in and the count of that entity type
+                switch (line[x]) {
+                case ' ': // ignore all empty spaces
+                    break;
+                case 'X': // setting the starting location
+                    newLevel.start = currentPos;
+                    break;
+                case 'E': // setting the location objective
+                    newLevel.end = currentPos;
+                    break;
+                case '#': // storing the location of each wall
+                    positions = newLevel.walls;
+                    count = &newLevel.wallCount;
+                    break;
+                case 'B':
+                    positions = newLevel.allEnemies[BASIC_ENEMY];
+                    count = &newLevel.enemyCounts[BASIC_ENEMY];
+                    break;
+                case 'P':
+                    positions = newLevel.allEnemies[PATROL_ENEMY];
+                    count = &newLevel.enemyCounts[PATROL_ENEMY];
+                    break;
+                case 't': // lowercase t: teleporter enemy
+                    positions = newLevel.allEnemies[TELEPORT_ENEMY];
+                    count = &newLevel.enemyCounts[TELEPORT_ENEMY];
                     break;
+                case 'C':
+                    positions = newLevel.allEnemies[CHASER_ENEMY];
+                    count = &newLevel.enemyCounts[CHASER_ENEMY];
+                    break;
+                case 'T': // uppercase T: bombper enemy
+                    positions = newLevel.allEnemies[TRAPPER_ENEMY];
+                    count = &newLevel.enemyCounts[TRAPPER_ENEMY];
+                    break;
+                case 's': // lowercase s: burst enemy
+                    positions = newLevel.allEnemies[BURST_ENEMY];
+                    count = &newLevel.enemyCounts[BURST_ENEMY];
+                    break;
+                case 'M':
+                    positions = newLevel.allEnemies[MIMIC_ENEMY];
+                    count = &newLevel.enemyCounts[MIMIC_ENEMY];
+                    break;
+                case 'W':
+                    positions = newLevel.allEnemies[WALL_BREAKER_ENEMY];
+                    count = &newLevel.enemyCounts[WALL_BREAKER_ENEMY];
+                    break;
+                case 'S': // uppercase S: shooter enemy
+                    positions = newLevel.allEnemies[SHOOTER_ENEMY];
+                    count = &newLevel.enemyCounts[SHOOTER_ENEMY];
+                    break;
+                case '!':
+                    positions = newLevel.allItems[OBJ_ITEM];
+                    count = &newLevel.itemCounts[OBJ_ITEM];
+                    break;
+                default: // immediately return an error upon encountering an unidentified entity type
+                    newLevel.hasError = UNKNOWN_ENEMY_TYPE;
+                    free(line);
+                    fclose(levelFile);
+                    return newLevel;
+                }
+
+                // the first pass only counts, and the second stores each position while counting the same entities again
+                if (count != NULL) {
+                    if (isStoring) positions[*count] = currentPos;
+                    (*count)++;
                 }
-                newLevel.allEnemies[i] = temp;
             }
         }
+    }
 
-        // reallocate memory for each item type array, same process as the enemy arrays
-        for (int i = 0; i < NUM_ITEM_TYPES; i++) {
-            if (newLevel.itemCounts[i] == 0) {
-                free(newLevel.allItems[i]);
-                newLevel.allItems[i] = NULL;
+    free(line);
+
+    finishLevelArrays(&newLevel);
+    fclose(levelFile);
+    return newLevel;
+}
+
+bool allocateLevelArrays(Level* newLevel) {
+
+    /* each array is allocated at exactly the size its count says, and a type that isn't in the level gets no array at all.
+        the counts are then set back to 0, since they're counted up again as the positions are stored. */
+    if (newLevel->wallCount > 0) {
+        newLevel->walls = malloc(sizeof(Position) * newLevel->wallCount);
+        if (newLevel->walls == NULL) {
+            newLevel->hasError = MALLOC_WALL_POSITION_FAILED;
+            return false;
+        }
+    }
+    newLevel->wallCount = 0;
+
+    for (int i = 0; i < NUM_ENEMY_TYPES; i++) {
+        if (newLevel->enemyCounts[i] > 0) {
+            newLevel->allEnemies[i] = malloc(sizeof(Position) * newLevel->enemyCounts[i]);
+            if (newLevel->allEnemies[i] == NULL) {
+                newLevel->hasError = MALLOC_ENEMY_POSITION_FAILED;
+                return false;
             }
-            else {
-                Position* temp = realloc(newLevel.allItems[i], sizeof(Position) * newLevel.itemCounts[i]);
-                if (temp == NULL) {
-                    newLevel.hasError = REALLOC_ITEM_COUNT_FAILED;
-                    break;
-                }
-                newLevel.allItems[i] = temp;
+        }
+        newLevel->enemyCounts[i] = 0;
+    }
+
+    for (int i = 0; i < NUM_ITEM_TYPES; i++) {
+        if (newLevel->itemCounts[i] > 0) {
+            newLevel->allItems[i] = malloc(sizeof(Position) * newLevel->itemCounts[i]);
+            if (newLevel->allItems[i] == NULL) {
+                newLevel->hasError = MALLOC_ALL_ITEMS_FAILED;
+                return false;
             }
         }
+        newLevel->itemCounts[i] = 0;
+    }
+    return true;
+}
+
+void finishLevelArrays(Level* newLevel) {
+
+    // finish initialization only if both the valid start and end positions have been identified
+    if (matchesPosition(newLevel->start, INVALID_POS)) {
+        newLevel->hasError = NO_PLAYER_EXISTS;
+        return;
+    }
+    else if (matchesPosition(newLevel->end, INVALID_POS)) {
+        newLevel->hasError = NO_EXIT_EXISTS;
+        return;
+    }
+
+    // if any items are present, change the objective of the game to collecting all items
+    if (newLevel->itemCounts[OBJ_ITEM] > 0) {
+        newLevel->objectiveID = ITEM_OBJ;
+    }
+}
+
+Level loadLevel(const char* fileName) {
+
+    // a level exported into the level pack is read straight from its record, and any other level from its text file
+    FILE* packFile = fopen(LEVEL_PACK_FILE, "rb");
+    if (packFile != NULL) {
+        long recordOffset = findLevelRecord(packFile, fileName);
+        if (recordOffset >= 0 && fseek(packFile, recordOffset, SEEK_SET) == 0) {
+            Level level = readLevelRecord(packFile);
+            fclose(packFile);
+            return level;
+        }
+        fclose(packFile);
+    }
+    return parseLevelLayout(fileName);
+}
+
+long findLevelRecord(FILE* packFile, const char* levelName) {
+
+    /* each record starts with the magic, the number of bytes that follow it, and the level's name. the pack is only
+        ever appended to, so a level exported again has a newer record further along that replaces the older one. */
+    long found = -1;
+    char magic[4];
+    int32_t recordSize;
+    char name[LEVEL_NAME_SIZE];
+
+    // the size is little-endian like every other number in a record, so it's read the same way as the rest of them
+    while (fread(magic, 1, 4, packFile) == 4 && memcmp(magic, LEVEL_RECORD_MAGIC, 4) == 0 &&
+        readRecordInts(packFile, &recordSize, 1) && recordSize >= LEVEL_NAME_SIZE &&
+        fread(name, 1, LEVEL_NAME_SIZE, packFile) == LEVEL_NAME_SIZE) {
+
+        if (strncmp(name, levelName, LEVEL_NAME_SIZE) == 0) {
+            found = ftell(packFile);
+        }
 
-        // if any items are present, change the objective of the game to collecting all items
-        if (newLevel.itemCounts[OBJ_ITEM] > 0) {
-            newLevel.objectiveID = ITEM_OBJ;
+        // skip over the rest of the record to the start of the next one
+        if (fseek(packFile, recordSize - LEVEL_NAME_SIZE, SEEK_CUR) != 0) {
+            break;
         }
     }
-    fclose(levelFile);
+    return found;
+}
+
+/* after its name, a record holds the board size, the start and exit, the count of every enemy and item type,
+    a bitmask of the walls (one bit per cell in row order), then the x and y of every enemy and item as 16 bit
+    pairs, grouped by type in the same order as the enums. every number is little-endian. */
+Level readLevelRecord(FILE* packFile) {
+    int32_t header[6]; // width, height, start x and y, exit x and y
+    int32_t counts[NUM_ENEMY_TYPES + NUM_ITEM_TYPES];
+    bool isRead = readRecordInts(packFile, header, 6) && readRecordInts(packFile, counts, NUM_ENEMY_TYPES + NUM_ITEM_TYPES);
+
+    int width = header[0], height = header[1];
+#ifdef FIXED_GRID_SIZE
+    bool isValidSize = isRead && width == GRID_SIZE && height == GRID_SIZE;
+#else
+    bool isValidSize = isRead && width >= MIN_BOARD_SIZE && width <= MAX_BOARD_SIZE && height >= MIN_BOARD_SIZE && height <= MAX_BOARD_SIZE;
+#endif
+
+    // the arrays are allocated with the default size when the record can't be trusted, the same as a bad text file
+    Level newLevel = initializeLevel(isValidSize ? width : GRID_SIZE, isValidSize ? height : GRID_SIZE);
+    if (newLevel.hasError) {
+        return newLevel;
+    }
+    else if (!isRead) {
+        newLevel.hasError = INVALID_LEVEL_RECORD;
+        return newLevel;
+    }
+    else if (!isValidSize) {
+        newLevel.hasError = INVALID_LEVEL_SIZE;
+        return newLevel;
+    }
+
+    // a missing start or exit is stored as INVALID_POS, which is reported the same way as for a text file once the arrays are finished
+    newLevel.start = (Position){ header[2], header[3] };
+    newLevel.end = (Position){ header[4], header[5] };
+    if ((!matchesPosition(newLevel.start, INVALID_POS) && !isOnBoard(newLevel.start, width, height)) ||
+        (!matchesPosition(newLevel.end, INVALID_POS) && !isOnBoard(newLevel.end, width, height))) {
+        newLevel.hasError = INVALID_LEVEL_RECORD;
+        return newLevel;
+    }
+
+    // no type can have more entities than there are cells on the board
+    for (int i = 0; i < NUM_ENEMY_TYPES + NUM_ITEM_TYPES; i++) {
+        if (counts[i] < 0 || counts[i] > width * height) {
+            newLevel.hasError = INVALID_LEVEL_RECORD;
+            return newLevel;
+        }
+    }
+
+    // the walls are counted from the mask so that every array can be allocated at exactly its size before any are filled
+    int maskSize = (width * height + 7) / 8;
+    unsigned char* wallMask = malloc(maskSize);
+    if (wallMask == NULL) {
+        newLevel.hasError = MALLOC_WALL_POSITION_FAILED;
+        return newLevel;
+    }
+    if (fread(wallMask, 1, maskSize, packFile) != (size_t)maskSize) {
+        newLevel.hasError = INVALID_LEVEL_RECORD;
+        free(wallMask);
+        return newLevel;
+    }
+    for (int i = 0; i < width * height; i++) {
+        if (wallMask[i / 8] & (1 << (i % 8))) {
+            newLevel.wallCount++;
+        }
+    }
+    for (int i = 0; i < NUM_ENEMY_TYPES; i++) {
+        newLevel.enemyCounts[i] = counts[i];
+    }
+    for (int i = 0; i < NUM_ITEM_TYPES; i++) {
+        newLevel.itemCounts[i] = counts[NUM_ENEMY_TYPES + i];
+    }
+    if (!allocateLevelArrays(&newLevel)) {
+        free(wallMask);
+        return newLevel;
+    }
+
+    // turn every set bit of the wall mask back into a wall position, in the same row order the text parser finds them
+    for (int i = 0; i < width * height; i++) {
+        if (wallMask[i / 8] & (1 << (i % 8))) {
+            newLevel.walls[newLevel.wallCount++] = (Position){ i % width, i / width };
+        }
+    }
+    free(wallMask);
+
+    for (int i = 0; i < NUM_ENEMY_TYPES + NUM_ITEM_TYPES; i++) {
+        bool isEnemy = i < NUM_ENEMY_TYPES;
+        Position* positions = isEnemy ? newLevel.allEnemies[i] : newLevel.allItems[i - NUM_ENEMY_TYPES];
+        for (int j = 0; j < counts[i]; j++) {
+            unsigned char pair[4];
+            if (fread(pair, 1, 4, packFile) != 4) {
+                newLevel.hasError = INVALID_LEVEL_RECORD;
+                return newLevel;
+            }
+            positions[j] = (Position){ pair[0] | pair[1] << 8, pair[2] | pair[3] << 8 };
+            if (!isOnBoard(positions[j], width, height)) {
+                newLevel.hasError = INVALID_LEVEL_RECORD;
+                return newLevel;
+            }
+        }
+
+        if (isEnemy) {
+            newLevel.enemyCounts[i] = counts[i];
+        }
+        else {
+            newLevel.itemCounts[i - NUM_ENEMY_TYPES] = counts[i];
+        }
+    }
+
+    finishLevelArrays(&newLevel);
     return newLevel;
 }
 
-Level initializeLevel(void) {
-    Level newLevel;
+bool isOnBoard(Position pos, int width, int height) {
+    return pos.x >= 0 && pos.x < width && pos.y >= 0 && pos.y < height;
+}
+
+bool readRecordInts(FILE* packFile, int32_t* values, int count) {
+    unsigned char bytes[4];
+
+    // assembled byte by byte so the record reads the same no matter the machine's byte order
+    for (int i = 0; i < count; i++) {
+        if (fread(bytes, 1, 4, packFile) != 4) {
+            return false;
+        }
+        values[i] = (int32_t)((uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24);
+    }
+    return true;
+}
 
-    // allocate memory for all dynamic arrays
-    newLevel.walls = malloc(sizeof(Position) * GRID_SIZE * GRID_SIZE);
-    newLevel.allItems = malloc(sizeof(Position*) * NUM_ITEM_TYPES);
-    newLevel.allEnemies = malloc(sizeof(Position*) * NUM_ENEMY_TYPES);
+Level initializeLevel(int width, int height) {
+    Level newLevel;
+    newLevel.width = width;
+    newLevel.height = height;
+
+    /* allocate memory for the lists of each type and their counts. the position arrays themselves are only allocated once
+        every type has been counted, so the lists start out empty, and the level can be freed no matter where this fails. */
+    newLevel.walls = NULL;
+    newLevel.allItems = calloc(NUM_ITEM_TYPES, sizeof(Position*));
+    newLevel.allEnemies = calloc(NUM_ENEMY_TYPES, sizeof(Position*));
     newLevel.enemyCounts = malloc(sizeof(int) * NUM_ENEMY_TYPES);
     newLevel.itemCounts = malloc(sizeof(int) * NUM_ITEM_TYPES);
 
     // return the necessary error code if any memory allocations fail
-    if (newLevel.walls == NULL) {
-        newLevel.hasError = MALLOC_WALL_POSITION_FAILED;
-    }
-    else if (newLevel.allItems == NULL) {
+    if (newLevel.allItems == NULL) {
         newLevel.hasError = MALLOC_ALL_ITEMS_FAILED;
     }
     else if (newLevel.allEnemies == NULL) {
@@ -1952,33 +4266,13 @@ Level initializeLevel(void) {
         newLevel.wallCount = 0;
         newLevel.objectiveID = EXIT_OBJ; // default objective: just reach the exit
 
-        // allocate memory for each enemy type
+        /* every count starts at 0. the level is counted up first, then allocateLevelArrays gives each type present
+            an array of exactly the size it needs, so no memory is wasted on types that aren't in the level or on
+            room for the worst case of one type covering the whole board. */
         for (int i = 0; i < NUM_ENEMY_TYPES; i++) {
-            Position* temp = malloc(sizeof(Position) * GRID_SIZE * GRID_SIZE);
-            if (temp == NULL) {
-                newLevel.hasError = MALLOC_ENEMY_POSITION_FAILED;
-                break;
-            }
-
-            /* note that the memory allocation is equal to the area of the grid. this is to ensure that
-                the worst case of memory allocation is taken of, which is when a single enemy type occupies
-                every space of the entire game board.
-
-                however, after the number of each enemy type is properly counted in the parseLevelLayout
-                function, the memory is later reallocated to a smaller size to avoid any memory wastage. */
-
-            newLevel.allEnemies[i] = temp;
             newLevel.enemyCounts[i] = 0;
         }
-
-        // allocate memory for each item type, again allocating each type for the worst case
         for (int i = 0; i < NUM_ITEM_TYPES; i++) {
-            Position* temp = malloc(sizeof(Position) * GRID_SIZE * GRID_SIZE);
-            if (temp == NULL) {
-                newLevel.hasError = MALLOC_ALL_ITEMS_FAILED;
-                break;
-            }
-            newLevel.allItems[i] = temp;
             newLevel.itemCounts[i] = 0; // the count of each item type is initialized to 0
         }
     }
@@ -1986,12 +4280,12 @@ Level initializeLevel(void) {
 }
 
 void freeLevel(Level* level) {
-    for (int i = 0; i < NUM_ENEMY_TYPES; i++) {
+    for (int i = 0; level->allEnemies != NULL && i < NUM_ENEMY_TYPES; i++) {
         free(level->allEnemies[i]);
     }
     free(level->allEnemies);
 
-    for (int i = 0; i < NUM_ITEM_TYPES; i++) {
+    for (int i = 0; level->allItems != NULL && i < NUM_ITEM_TYPES; i++) {
         free(level->allItems[i]);
     }
     free(level->allItems);
@@ -2152,6 +4446,18 @@ void printErrorMessage(ErrorCode err, int level) {
     case MALLOC_ITEM_COUNT_FAILED:
         fprintf(stderr, "Memory allocation for item count array failed.\n");
         break;
+    case MALLOC_NAVIGATION_MAP_FAILED:
+        fprintf(stderr, "Memory allocation for the navigation map failed.\n");
+        break;
+    case MALLOC_ENEMY_SCHEDULER_FAILED:
+        fprintf(stderr, "Memory allocation for the enemy scheduler failed.\n");
+        break;
+    case INVALID_LEVEL_SIZE:
+        fprintf(stderr, "The board size in the level file's header is not supported.\n");
+        break;
+    case INVALID_LEVEL_RECORD:
+        fprintf(stderr, "The level's record in the level pack is damaged.\n");
+        break;
     }
 }
 
@@ -2183,7 +4489,203 @@ void printObjective(ObjectiveType ID, HANDLE hConsole, int level) {
     SetConsoleTextAttribute(hConsole, WHITE);
 }
 
+int benchmarkPathfinding(void) {
+    const int numSearches = 2000;
+    int totalLevels = sizeof(allLevelFiles) / sizeof(char*);
+    srand(1); // the same start and end positions are picked on every run
+
+    printf("PATHFINDING BENCHMARK: %d searches per level\n\n", numSearches);
+    printf("%-14s %12s %12s %9s %12s %10s\n", "Level", "A* (ms)", "JPS (ms)", "Speedup", "Table (ms)", "Mismatches");
+
+    /* time the searches the enemies actually run (the sliced A* and JPS requests, with A* going over the cluster graph
+        on large boards) between the same random pairs of open cells on every level that can be loaded. each is checked
+        against an untimed full-grid A* search, which always finds a shortest path. */
+    for (int i = 1; i < totalLevels; i++) {
+        Level level = loadLevel(allLevelFiles[i]);
+        if (level.hasError) {
+            freeLevel(&level);
+            continue;
+        }
+        GameBoard game = initializeGameBoard(level, 1);
+        if (game.hasError) {
+            freeGameBoard(level, &game);
+            freeLevel(&level);
+            continue;
+        }
+
+        Position* aStarPath = malloc(sizeof(Position) * game.grid.navMap->cellCount);
+        Position* jumpPath = malloc(sizeof(Position) * game.grid.navMap->cellCount);
+        clock_t aStarTime = 0, jumpPointTime = 0, tableTime = 0;
+        int mismatches = 0;
+
+        for (int j = 0; j < numSearches; j++) {
+            Position start, end;
+            do {
+                start = (Position){ rand() % (level.width - 2) + 1, rand() % (level.height - 2) + 1 };
+                end = (Position){ rand() % (level.width - 2) + 1, rand() % (level.height - 2) + 1 };
+            } while (!isValid(game.grid, start, 'e') || !isValid(game.grid, end, 'e'));
+
+            int shortestLength = 0, aStarLength = 0, jumpPointLength = 0;
+            bool shortestFound = findPath(game.grid, start, end, game.grid.navMap->path, &shortestLength);
+
+            clock_t searchStart = clock();
+            bool aStarFound = runPathRequest(game.grid, ASTAR_SEARCH, start, end, aStarPath, &aStarLength);
+            aStarTime += clock() - searchStart;
+
+            searchStart = clock();
+            bool jumpPointFound = runPathRequest(game.grid, JUMP_POINT_SEARCH, start, end, jumpPath, &jumpPointLength);
+            jumpPointTime += clock() - searchStart;
+
+            // the grid searches should always find a shortest path, the same length as the full-grid A*'s
+            if (jumpPointFound != shortestFound || (shortestFound && jumpPointLength != shortestLength)) {
+                mismatches++;
+            }
+
+            /* the cluster graph only knows about walls, so it can walk thru the enemies the other searches go around, and
+                its paths aren't always the shortest. all it has to do is find a path whenever the others can. */
+            if (game.grid.navMap->clusters != NULL ? (shortestFound && !aStarFound) : (aStarFound != shortestFound || (shortestFound && aStarLength != shortestLength))) {
+                mismatches++;
+            }
+
+            // walk the next-hop table's path one step at a time, the same way an enemy would
+            if (game.grid.navMap->nextHops != NULL) {
+                int tableLength = 1;
+                bool tableFound = true;
+                searchStart = clock();
+                for (Position pos = start; !matchesPosition(pos, end) && tableFound; tableLength++) {
+                    tableFound = findNextHop(game.grid, pos, end, &pos) && tableLength <= game.grid.navMap->cellCount;
+                }
+                tableTime += clock() - searchStart;
+
+                // the table doesn't see the enemies the searches have to go around, so its path can only be as short or shorter
+                if ((shortestFound && !tableFound) || (shortestFound && tableLength > shortestLength)) {
+                    mismatches++;
+                }
+            }
+        }
+
+        double aStarMs = 1000.0 * aStarTime / CLOCKS_PER_SEC;
+        double jumpPointMs = 1000.0 * jumpPointTime / CLOCKS_PER_SEC;
+        char tableMs[16] = "-"; // levels that can destroy walls don't have a table
+        if (game.grid.navMap->nextHops != NULL) {
+            snprintf(tableMs, sizeof(tableMs), "%.2f", 1000.0 * tableTime / CLOCKS_PER_SEC);
+        }
+        printf("%-14s %12.2f %12.2f %8.2fx %12s %10d\n", allLevelFiles[i], aStarMs, jumpPointMs,
+            jumpPointMs > 0 ? aStarMs / jumpPointMs : 0.0, tableMs, mismatches);
+
+        free(aStarPath);
+        free(jumpPath);
+        freeGameBoard(level, &game);
+        freeLevel(&level);
+    }
+    return 0;
+}
+
+int benchmarkEnemyPlanning(void) {
+    const int numFrames = 600;
+    int totalLevels = sizeof(allLevelFiles) / sizeof(char*);
+    int mismatches = 0;
+
+    printf("ENEMY PLANNING BENCHMARK: %d frames per level\n\n", numFrames);
+    printf("%-14s %8s %8s %14s %14s %9s %8s\n", "Level", "Enemies", "Threads", "1 thread (ms)", "Pool (ms)", "Speedup", "Same");
+
+    /* play the first frames of every level that can be loaded twice from the same seed, once with the planning phase (the line
+        of sight checks and the sliced path searches) kept on this thread and once split across the thread pool, with the player
+        standing still at the start. every enemy's position is hashed after every frame, so the runs only match if every enemy
+        made the same move on every frame. levels with fewer than MIN_PARALLEL_SIGHT_BATCHES * SIGHT_BATCH enemies that can see
+        never hand their sight checks to the pool, so it's the crowded levels that actually test the threads. */
+    for (int i = 1; i < totalLevels; i++) {
+        uint64_t hashes[2] = { 0, 0 };
+        clock_t planningTimes[2] = { 0, 0 };
+        int enemyCount = 0;
+        int poolThreads = 1;
+        bool isLoaded = true;
+
+        for (int run = 0; run < 2 && isLoaded; run++) {
+            srand(1); // both runs pick the same roaming orders and random moves, as long as every enemy sees the same things
+            Level level = loadLevel(allLevelFiles[i]);
+            if (level.hasError) {
+                freeLevel(&level);
+                isLoaded = false;
+                break;
+            }
+            GameBoard game = initializeGameBoard(level, 1);
+            if (game.hasError) {
+                freeGameBoard(level, &game);
+                freeLevel(&level);
+                isLoaded = false;
+                break;
+            }
+
+            // the first run only lets the pool use this thread, the same as when the pool couldn't be created
+            if (game.grid.workers != NULL) {
+                if (run == 0) game.grid.workers->workerCount = 1;
+                else poolThreads = game.grid.workers->workerCount;
+            }
+
+            Particle* allBombs = NULL;
+            Particle* allExplosions = NULL;
+            Bullet* allBullets = NULL;
+            uint64_t hash = 14695981039346656037ULL; // FNV-1a
+
+            /* the same frame as the game loop, less the player, the drawing and the bullets. a shooter that fires without moving
+                gives its bullet no direction to travel in, which a player standing still makes happen all the time, so the
+                bullets are left where they're fired and just freed at the end. */
+            for (int frameCounter = 1; frameCounter <= numFrames; frameCounter++) {
+                updateAllParticles(&allBombs, &allExplosions, &game.grid, frameCounter);
+
+                clock_t frameStart = clock();
+                moveAllEnemies(frameCounter, &game.grid, game.allEnemies, game.scheduler, game.player, &allBombs, &allBullets);
+                planningTimes[run] += clock() - frameStart;
+
+                for (int type = 0; type < NUM_ENEMY_TYPES; type++) {
+                    for (int j = 0; j < level.enemyCounts[type]; j++) {
+                        hash = (hash ^ (uint32_t)game.allEnemies[type][j].pos.x) * 1099511628211ULL;
+                        hash = (hash ^ (uint32_t)game.allEnemies[type][j].pos.y) * 1099511628211ULL;
+                    }
+                }
+            }
+            hashes[run] = hash;
+
+            enemyCount = 0;
+            for (int type = 0; type < NUM_ENEMY_TYPES; type++) {
+                enemyCount += level.enemyCounts[type];
+            }
+
+            freeBombs(allBombs, allExplosions);
+            while (allBullets != NULL) {
+                Bullet* temp = allBullets;
+                allBullets = allBullets->next;
+                free(temp);
+            }
+            freeGameBoard(level, &game);
+            freeLevel(&level);
+        }
+        if (!isLoaded) continue;
+
+        if (hashes[0] != hashes[1]) {
+            mismatches++;
+        }
+        double singleMs = 1000.0 * planningTimes[0] / CLOCKS_PER_SEC;
+        double poolMs = 1000.0 * planningTimes[1] / CLOCKS_PER_SEC;
+        printf("%-14s %8d %8d %14.2f %14.2f %8.2fx %8s\n", allLevelFiles[i], enemyCount, poolThreads, singleMs, poolMs,
+            poolMs > 0 ? singleMs / poolMs : 0.0, (hashes[0] == hashes[1]) ? "yes" : "NO");
+    }
+
+    // a nonzero exit code means some level played out differently on the thread pool
+    return (mismatches > 0) ? 1 : 0;
+}
+
 int main(void) {
+
+    // build with PATHFINDING_BENCHMARK defined to compare the enemies' A* and jump point searches (and the next-hop table) on the shipped levels instead of playing,
+    // or with ENEMY_PLANNING_BENCHMARK defined to check that the enemies move the same with and without the thread pool
+#ifdef PATHFINDING_BENCHMARK
+    return benchmarkPathfinding();
+#elif defined(ENEMY_PLANNING_BENCHMARK)
+    return benchmarkEnemyPlanning();
+#else
+
     srand(time(NULL));
     HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE); // used to change the color of text
 
@@ -2204,7 +4706,7 @@ int main(void) {
             system("cls");
 
             // determine if the level file has any errors before continuing to load it into the game
-            Level level = parseLevelLayout(allLevelFiles[i]);
+            Level level = loadLevel(allLevelFiles[i]);
             if (level.hasError) {
                 printErrorMessage(level.hasError, i);
                 freeLevel(&level);
@@ -2215,13 +4717,16 @@ int main(void) {
             GameBoard game = initializeGameBoard(level, 1);
             if (game.hasError) {
                 printErrorMessage(game.hasError, i);
+                freeGameBoard(level, &game);
                 freeLevel(&level);
-                freeGameBoard(&game);
                 return game.hasError;
             }
 
             printObjective(level.objectiveID, hConsole, i);
 
+            // the menu shown after the level ends goes right below the board, which depends on the level's size
+            const Position postlevelCursor = { 0, level.height + 5 };
+
             // begin the game: this function returns true if the game is won, and false if lost
             if (gameLoop(&level, &game)) {
 
@@ -2235,7 +4740,7 @@ int main(void) {
             }
             else { // print the game over screen from the text file if the player loses
                 system("cls");
-                Level gameOver = parseLevelLayout(allLevelFiles[0]);
+                Level gameOver = loadLevel(allLevelFiles[0]);
                 GameBoard gameOverScreen = initializeGameBoard(gameOver, 0);
                 drawGameState(gameOverScreen.grid, gameOver);
 
@@ -2246,13 +4751,13 @@ int main(void) {
                 }
                 else i--; // restart the level by decrementing the index (since the for-loop increments it every iteration)
 
+                freeGameBoard(gameOver, &gameOverScreen);
                 freeLevel(&gameOver);
-                freeGameBoard(&gameOverScreen);
             }
 
             // clean up the memory allocated to parse the level files and the game board
+            freeGameBoard(level, &game);
             freeLevel(&level);
-            freeGameBoard(&game);
 
             // break out of the level-traversal loop to return to the infinite loop
             if (backToMainFlag) break;
@@ -2260,4 +4765,5 @@ int main(void) {
     }
     _CrtDumpMemoryLeaks();
     return 0;
+#endif
 }
\ No newline at end of file
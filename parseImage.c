@@ -6,21 +6,56 @@
 * will then be outputted to the game files as it will be read in
 * to be a playable level.
 * 
-* All PNG images inputted are 23x23 pixels to replicate the game board.
+* Most PNG images inputted are 23x23 pixels to replicate the game board.
 * The PNG image was designed in a pixel art website, so by using a palette
 * of predetermined RGB colors, I could design my own levels as pixel art 
 * in the website, output that art as a 23x23 PNG, then have this program 
 * analyze each pixel to map each RGB value to a specific game entity at 
 * that location. For instance, a black pixel means a wall, and a red pixel
-* means the player's starting location.
+* means the player's starting location. Images of any other size the
+* game can load (4x4 up to 1024x1024) are converted too, with a "width
+* height" header at the top of the level, and are decoded a row at a time
+* so big maps never sit in memory whole.
+* 
+* Running it as "parseImage --batch <folder or pattern> <output folder>"
+* converts every matching PNG at once across a thread pool, writing each
+* level to a text file named after its image.
+* 
+* Running it as "parseImage --pack <image.png> <level name> <pack file>"
+* appends the level to a pack file as a binary record instead, which the
+* game loads directly without parsing any text. Records keep the image's
+* size, the same as the text files.
+* 
+* The colors each entity is drawn with are read from palette.cfg at
+* startup (or the file given with "--palette <file>" before any other
+* arguments), one "R G B 'marker'" line per color, where each marker has
+* to be one the game reads. A palette given with "--palette" has to exist,
+* but without the default palette.cfg the built-in colors below are used.
 */
 
 #define _CRT_SECURE_NO_WARNINGS
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #include <stdint.h>
+#include <windows.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 #define GRID_SIZE 23 // dimensions of the game board
+#define MAX_BATCH_THREADS 8 // most threads a batch conversion is split across
+#define MIN_BOARD_SIZE 4 // narrowest or shortest board the game will load (the same as newGame.c's)
+#define MAX_BOARD_SIZE 1024 // widest or tallest board the game will load (the same as newGame.c's), so no bigger image is converted
+#define INFLATE_WINDOW_SIZE 32768 // furthest back a deflate stream can copy from (a power of 2 so wrapping is just a mask)
+#define MAX_SIMD_PALETTE 32 // palettes up to this size are matched by comparing every color at once, and bigger ones by hash lookup
+
+// binary level records, laid out the same way newGame.c's readLevelRecord reads them
+#define LEVEL_RECORD_MAGIC "LVLR"
+#define LEVEL_NAME_SIZE 32 // bytes of each record's level name, padded with nulls
+#define NUM_RECORD_TYPES 13 // newGame.c's 9 enemy types followed by its 4 item types
+
+// each pixel's RGB values packed into one 24 bit key (red in the low byte), so matching a color is a single compare
+#define COLOR_KEY(r, g, b) ((uint32_t)(r) | (uint32_t)(g) << 8 | (uint32_t)(b) << 16)
 
 typedef struct {
     int r, g, b;
@@ -31,12 +66,109 @@ typedef struct {
     char gridMarker;
 } ColorMap;
 
-void imageToGrid(const char* imageName, char grid[GRID_SIZE][GRID_SIZE]);
-void gridToTxt(char* fileName, char grid[GRID_SIZE][GRID_SIZE]);
-char determineChar(Pixel pixel);
-int matchesColor(Pixel x, Pixel y);
+/* the colors that map to entities. they're kept in the order they were listed for the AVX2 matcher, and in an
+    open addressing hash table (at most half full) so a single color is found in O(1) no matter how big the palette is. */
+typedef struct {
+    uint32_t* keys;
+    char* markers;
+    int count;
+    int capacity;
+    uint32_t* slotKeys; // each slot's color key with SLOT_USED set, or 0 if the slot is empty
+    char* slotMarkers;
+    int slotMask;
+} Palette;
+#define SLOT_USED 0x1000000 // above the 24 bits of a color key, so black (key 0) can be told apart from an empty slot
+
+typedef struct { // every image in a batch conversion and where its level file goes, shared by all the worker threads
+    char** imagePaths;
+    char** levelPaths;
+    int fileCount;
+    volatile LONG nextFile; // the last file claimed by a worker
+    volatile LONG failedCount;
+} BatchJob;
+
+typedef enum { // the kinds of deflate block, numbered the same as in the block headers
+    STORED_BLOCK,
+    FIXED_BLOCK,
+    DYNAMIC_BLOCK,
+    NO_BLOCK = -1 // between blocks
+} BlockType;
+
+typedef struct { // a canonical Huffman code, stored as the number of codes of each length and the symbols in code order
+    short counts[16];
+    short symbols[288];
+} HuffmanCode;
+
+/* an image being read one row at a time. 8 bit RGB(A) and palette PNGs are inflated straight out of their IDAT chunks as
+    rows are asked for, so only two rows and the inflate window are ever held in memory. other images are decoded whole by stb_image. */
+typedef struct {
+    FILE* file;
+    int width, height;
+    int row; // rows handed out so far
+    int colorType;
+    int bitDepth;
+    int bytesPerPixel; // the distance back the filters look, which is 1 for palette images of any bit depth
+    int rowBytes;
+    char paletteMarkers[256]; // the marker for each palette index, looked up once from the PLTE chunk
+    uint8_t* previousRow; // the unfiltered row above, which each row's filter is relative to
+    uint8_t* currentRow;
+    uint8_t* rgbRow; // RGBA rows packed down to RGB
+    uint8_t* wholeImage;
 
-// all entity type markers and their corresponding RGB values
+    uint32_t chunkLeft; // bytes of the current IDAT chunk not read in yet
+    uint8_t input[4096];
+    int inputSize;
+    int inputPosition;
+
+    uint32_t bitBuffer;
+    int bitCount;
+    int hasFailed; // set once the image data runs out partway through a value
+    BlockType blockType;
+    int isLastBlock;
+    int storedLeft;
+    HuffmanCode lengthCode;
+    HuffmanCode distanceCode;
+    int copyLeft;
+    int copyDistance;
+    uint8_t window[INFLATE_WINDOW_SIZE];
+    uint32_t windowPosition;
+    int windowFill; // bytes of the window holding output so far
+} ImageRows;
+
+char* imageToGrid(const char* imageName, int* width, int* height);
+int imageToTxt(const char* imageName, const char* filePath);
+ImageRows* openImageRows(const char* imageName);
+int isBoardSize(int width, int height);
+int findImageData(ImageRows* rows);
+int readImageRow(ImageRows* rows, char* markers);
+void closeImageRows(ImageRows* rows);
+uint32_t readBigEndian(const uint8_t* bytes);
+void unfilterRow(uint8_t* row, const uint8_t* previous, int rowBytes, int bytesPerPixel, int filter);
+int nextImageByte(ImageRows* rows);
+int getBits(ImageRows* rows, int count);
+int inflateBytes(ImageRows* rows, uint8_t* out, int count);
+int startInflateBlock(ImageRows* rows);
+int readDynamicCodes(ImageRows* rows);
+int buildHuffmanCode(HuffmanCode* code, const short* lengths, int symbolCount);
+int decodeSymbol(ImageRows* rows, const HuffmanCode* code);
+int gridToRecord(const char* packPath, const char* levelName, const char* grid, int width, int height);
+unsigned char* putRecordInt(unsigned char* cursor, int32_t value);
+int convertBatch(const char* inputPattern, const char* outputFolder);
+int findBatchImages(const char* inputPattern, const char* outputFolder, BatchJob* job);
+char* joinPath(const char* folder, const char* fileName, size_t nameLength, const char* extension);
+VOID CALLBACK runBatchWorker(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work);
+void convertBatchFiles(BatchJob* job);
+void freeBatchJob(BatchJob* job);
+int loadPalette(const char* fileName, int mustExist);
+int isGameMarker(char marker);
+int addPaletteColor(uint32_t colorKey, char marker);
+int buildPaletteTable(const char* fileName);
+uint32_t hashColorKey(uint32_t colorKey);
+void freePalette(void);
+char determineChar(uint32_t colorKey);
+void convertPixels(const uint8_t* rgb, int pixelCount, char* markers);
+
+// the entity type markers and their corresponding RGB values used when there's no palette file
 const ColorMap allMarkers[] = {
     {{0, 0, 0}, '#'},
     {{255, 255, 255}, ' '},
@@ -51,104 +183,1149 @@ const ColorMap allMarkers[] = {
     {{128, 0, 255}, 'M'},
     {{128, 128, 128}, 'W'},
     {{128, 128, 0}, 'S'},
-    {{91, 36, 1}, '!'},
-    {{222, 169, 135}, '?'},
-    {{6, 85, 53}, '?'},
-    {{0, 51, 102}, '?'}
+    {{91, 36, 1}, '!'}
 };
+#define NUM_MARKERS (int)(sizeof(allMarkers) / sizeof(allMarkers[0]))
+
+Palette palette; // loaded once at startup, and only read after that (including by the batch worker threads)
+
+// the marker of each enemy type then each item type in a level record, in the order of newGame.c's EnemyType and ItemType
+// enums (the last 3 item types have no marker in the game yet, so they're always empty)
+const char recordMarkers[NUM_RECORD_TYPES] = { 'B', 'P', 't', 'C', 'T', 's', 'M', 'W', 'S', '!', 0, 0, 0 };
 
 // defining the output file directory (which is in the main game's folder)
 char* outputDirectory = "C:/Users/altav/source/repos/Project39/Project39/";
 
 int main(int argc, char* argv[]) {
-    char grid[GRID_SIZE][GRID_SIZE];
-    char imageName[20];
-    char fileName[20];
 
-    // copy the command line arguments to the image and file name variables
-    strcpy(imageName, argv[1]);
-    strcpy(fileName, argv[2]);
+    // a palette file given on the command line comes before the rest of the arguments
+    const char* paletteFile = "palette.cfg";
+    int paletteGiven = 0;
+    if (argc >= 3 && strcmp(argv[1], "--palette") == 0) {
+        paletteFile = argv[2];
+        paletteGiven = 1;
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+    if (!loadPalette(paletteFile, paletteGiven)) {
+        freePalette();
+        return 1;
+    }
+    atexit(freePalette);
+
+    // batch mode converts every PNG in a folder (or matching a wildcard pattern) into a level file of the same name
+    if (argc == 4 && strcmp(argv[1], "--batch") == 0) {
+        return convertBatch(argv[2], argv[3]) ? 0 : 1;
+    }
+
+    // pack mode appends the level to a pack file as a binary record, named so the game can find it in place of its text file
+    if (argc == 5 && strcmp(argv[1], "--pack") == 0) {
+        int width, height;
+        char* grid = imageToGrid(argv[2], &width, &height);
+        int packed = grid != NULL && gridToRecord(argv[4], argv[3], grid, width, height);
+        free(grid);
+        return packed ? 0 : 1;
+    }
+
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <image.png> <level.txt>\n", argv[0]);
+        fprintf(stderr, "       %s --batch <image folder or pattern> <output folder>\n", argv[0]);
+        fprintf(stderr, "       %s --pack <image.png> <level name> <pack file>\n", argv[0]);
+        fprintf(stderr, "any of these can start with --palette <palette file>\n");
+        return 1;
+    }
+
+    // concatenate the file name to the defined file path to prepare being opened
+    char* filePath = joinPath(outputDirectory, argv[2], strlen(argv[2]), "");
+    if (filePath == NULL) {
+        return 1;
+    }
+
+    int converted = imageToTxt(argv[1], filePath);
+    free(filePath);
+
+    return converted ? 0 : 1;
+}
+
+int convertBatch(const char* inputPattern, const char* outputFolder) {
+    BatchJob job = { 0 };
+    if (!findBatchImages(inputPattern, outputFolder, &job)) {
+        freeBatchJob(&job);
+        return 0;
+    }
+
+    if (job.fileCount == 0) {
+        fprintf(stderr, "ERROR: No images were found matching %s\n", inputPattern);
+        freeBatchJob(&job);
+        return 0;
+    }
+
+    // the output folder may already exist, in which case there's nothing to make
+    CreateDirectoryA(outputFolder, NULL);
+
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    int threadCount = (int)systemInfo.dwNumberOfProcessors;
+    if (threadCount > MAX_BATCH_THREADS) threadCount = MAX_BATCH_THREADS;
+    if (threadCount > job.fileCount) threadCount = job.fileCount;
+
+    /* every worker (and this thread) claims the next unconverted file until none are left, so a slow image
+        only holds up the thread converting it. if the thread pool isn't available, this thread converts them all. */
+    job.nextFile = -1;
+    PTP_WORK work = threadCount > 1 ? CreateThreadpoolWork(runBatchWorker, &job, NULL) : NULL;
+    if (work != NULL) {
+        for (int i = 1; i < threadCount; i++) {
+            SubmitThreadpoolWork(work);
+        }
+    }
+    convertBatchFiles(&job);
+    if (work != NULL) {
+        WaitForThreadpoolWorkCallbacks(work, FALSE);
+        CloseThreadpoolWork(work);
+    }
+
+    printf("Converted %d of %d images\n", job.fileCount - (int)job.failedCount, job.fileCount);
+    int allConverted = job.failedCount == 0;
+    freeBatchJob(&job);
+
+    return allConverted;
+}
+
+int findBatchImages(const char* inputPattern, const char* outputFolder, BatchJob* job) {
+
+    // a folder on its own means every PNG inside it
+    char* pattern;
+    DWORD attributes = GetFileAttributesA(inputPattern);
+    if (attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY)) {
+        pattern = joinPath(inputPattern, "*.png", 5, "");
+    }
+    else {
+        pattern = joinPath("", inputPattern, strlen(inputPattern), "");
+    }
+    if (pattern == NULL) {
+        return 0;
+    }
+
+    WIN32_FIND_DATAA found;
+    HANDLE search = FindFirstFileA(pattern, &found);
+    if (search == INVALID_HANDLE_VALUE) {
+        free(pattern);
+        return 1; // nothing matched, which the caller reports
+    }
+
+    // the matched names don't include their folder, so cut the pattern down to the part before its last slash
+    char* lastSlash = strrchr(pattern, '/');
+    char* lastBackslash = strrchr(pattern, '\\');
+    if (lastBackslash != NULL && (lastSlash == NULL || lastBackslash > lastSlash)) {
+        lastSlash = lastBackslash;
+    }
+    if (lastSlash != NULL) {
+        lastSlash[1] = '\0';
+    }
+    else {
+        pattern[0] = '\0';
+    }
+
+    int capacity = 0;
+    int succeeded = 1;
+    do {
+        if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            continue;
+        }
+
+        // grow both lists together, doubling their size whenever they fill up
+        if (job->fileCount == capacity) {
+            int newCapacity = capacity == 0 ? 16 : capacity * 2;
+            char** imagePaths = realloc(job->imagePaths, newCapacity * sizeof(char*));
+            if (imagePaths != NULL) job->imagePaths = imagePaths;
+            char** levelPaths = realloc(job->levelPaths, newCapacity * sizeof(char*));
+            if (levelPaths != NULL) job->levelPaths = levelPaths;
+
+            if (imagePaths == NULL || levelPaths == NULL) {
+                fprintf(stderr, "MALLOC ERROR: Memory allocation for the batch file list failed!\n");
+                succeeded = 0;
+                break;
+            }
+            capacity = newCapacity;
+        }
+
+        // each level file is named after its image, with the extension swapped for .txt
+        char* extension = strrchr(found.cFileName, '.');
+        size_t stemLength = extension != NULL ? (size_t)(extension - found.cFileName) : strlen(found.cFileName);
+        char* imagePath = joinPath(pattern, found.cFileName, strlen(found.cFileName), "");
+        char* levelPath = joinPath(outputFolder, found.cFileName, stemLength, ".txt");
+        if (imagePath == NULL || levelPath == NULL) {
+            free(imagePath);
+            free(levelPath);
+            succeeded = 0;
+            break;
+        }
+
+        job->imagePaths[job->fileCount] = imagePath;
+        job->levelPaths[job->fileCount] = levelPath;
+        job->fileCount++;
+    } while (FindNextFileA(search, &found));
+
+    FindClose(search);
+    free(pattern);
+    return succeeded;
+}
+
+char* joinPath(const char* folder, const char* fileName, size_t nameLength, const char* extension) {
+    size_t folderLength = strlen(folder);
+
+    // only add a slash between the folder and the file name if the folder doesn't already end with one
+    int needsSlash = folderLength > 0 && folder[folderLength - 1] != '/' && folder[folderLength - 1] != '\\';
+
+    char* path = malloc(folderLength + needsSlash + nameLength + strlen(extension) + 1);
+    if (path == NULL) {
+        fprintf(stderr, "MALLOC ERROR: Memory allocation for a file path failed!\n");
+        return NULL;
+    }
+
+    memcpy(path, folder, folderLength);
+    if (needsSlash) {
+        path[folderLength] = '/';
+    }
+    memcpy(path + folderLength + needsSlash, fileName, nameLength);
+    strcpy(path + folderLength + needsSlash + nameLength, extension);
+
+    return path;
+}
+
+VOID CALLBACK runBatchWorker(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work) {
+    convertBatchFiles(context);
+}
+
+void convertBatchFiles(BatchJob* job) {
+
+    // keep claiming the next file in the list until every file has been taken
+    LONG file;
+    while ((file = InterlockedIncrement(&job->nextFile)) < job->fileCount) {
+        if (!imageToTxt(job->imagePaths[file], job->levelPaths[file])) {
+            fprintf(stderr, "ERROR: %s could not be converted\n", job->imagePaths[file]);
+            InterlockedIncrement(&job->failedCount);
+        }
+    }
+}
+
+void freeBatchJob(BatchJob* job) {
+    for (int i = 0; i < job->fileCount; i++) {
+        free(job->imagePaths[i]);
+        free(job->levelPaths[i]);
+    }
+    free(job->imagePaths);
+    free(job->levelPaths);
+}
+
+/* a record is the magic, the number of bytes after it, the level's name, the board size, the start and exit, the count of
+    every enemy and item type, a bitmask of the walls (one bit per cell in row order), then the x and y of every enemy and
+    item as 16 bit pairs, grouped by type. the whole record is built in memory and appended to the pack with one write. */
+int gridToRecord(const char* packPath, const char* levelName, const char* grid, int width, int height) {
+    if (strlen(levelName) >= LEVEL_NAME_SIZE) {
+        fprintf(stderr, "ERROR: Level names in a pack can be at most %d characters\n", LEVEL_NAME_SIZE - 1);
+        return 0;
+    }
+
+    // find the start and exit, and count every type so the record's size is known before building it
+    int counts[NUM_RECORD_TYPES] = { 0 };
+    int entityCount = 0;
+    int startX = -1, startY = -1, endX = -1, endY = -1;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            char marker = grid[(size_t)y * width + x];
+            if (marker == 'X') {
+                startX = x;
+                startY = y;
+            }
+            else if (marker == 'E') {
+                endX = x;
+                endY = y;
+            }
+
+            for (int i = 0; i < NUM_RECORD_TYPES; i++) {
+                if (recordMarkers[i] != 0 && marker == recordMarkers[i]) {
+                    counts[i]++;
+                    entityCount++;
+                }
+            }
+        }
+    }
+
+    int maskSize = (width * height + 7) / 8;
+    int recordSize = LEVEL_NAME_SIZE + 6 * 4 + NUM_RECORD_TYPES * 4 + maskSize + entityCount * 4;
+    unsigned char* record = calloc(8 + recordSize, 1); // zeroed so the name's padding and the wall mask start empty
+    if (record == NULL) {
+        fprintf(stderr, "MALLOC ERROR: Memory allocation for the level record failed!\n");
+        return 0;
+    }
+
+    unsigned char* cursor = record;
+    memcpy(cursor, LEVEL_RECORD_MAGIC, 4);
+    cursor = putRecordInt(cursor + 4, recordSize);
+    memcpy(cursor, levelName, strlen(levelName));
+    cursor += LEVEL_NAME_SIZE;
+
+    int32_t header[] = { width, height, startX, startY, endX, endY };
+    for (int i = 0; i < 6; i++) {
+        cursor = putRecordInt(cursor, header[i]);
+    }
+    for (int i = 0; i < NUM_RECORD_TYPES; i++) {
+        cursor = putRecordInt(cursor, counts[i]);
+    }
+
+    for (int i = 0; i < width * height; i++) {
+        if (grid[i] == '#') {
+            cursor[i / 8] |= 1 << (i % 8);
+        }
+    }
+    cursor += maskSize;
+
+    // each type's positions in row order, the same order the game's text parser finds them in
+    for (int i = 0; i < NUM_RECORD_TYPES; i++) {
+        for (int y = 0; y < height && counts[i] > 0; y++) {
+            for (int x = 0; x < width; x++) {
+                if (grid[(size_t)y * width + x] == recordMarkers[i]) {
+                    cursor[0] = x & 0xFF;
+                    cursor[1] = x >> 8;
+                    cursor[2] = y & 0xFF;
+                    cursor[3] = y >> 8;
+                    cursor += 4;
+                }
+            }
+        }
+    }
+
+    FILE* packFile = fopen(packPath, "ab");
+    if (packFile == NULL) {
+        fprintf(stderr, "ERROR: Could not open the level pack %s\n", packPath);
+        free(record);
+        return 0;
+    }
+
+    int written = fwrite(record, 1, 8 + recordSize, packFile) == (size_t)(8 + recordSize);
+    if (fclose(packFile) != 0 || !written) {
+        fprintf(stderr, "ERROR: Could not write the level record to %s\n", packPath);
+        written = 0;
+    }
+    free(record);
+
+    return written;
+}
+
+unsigned char* putRecordInt(unsigned char* cursor, int32_t value) {
+
+    // written byte by byte so the record is little-endian no matter the machine's byte order
+    uint32_t bits = (uint32_t)value;
+    for (int i = 0; i < 4; i++) {
+        cursor[i] = (bits >> (8 * i)) & 0xFF;
+    }
+    return cursor + 4;
+}
+
+int loadPalette(const char* fileName, int mustExist) {
+    FILE* paletteFile = fopen(fileName, "r");
+    if (paletteFile == NULL && mustExist) {
+        fprintf(stderr, "ERROR: Could not open the palette file %s\n", fileName);
+        return 0;
+    }
+
+    // without the default palette file, fall back to the colors the levels have always been drawn with
+    if (paletteFile == NULL) {
+        for (int i = 0; i < NUM_MARKERS; i++) {
+            if (!addPaletteColor(COLOR_KEY(allMarkers[i].color.r, allMarkers[i].color.g, allMarkers[i].color.b), allMarkers[i].gridMarker)) {
+                return 0;
+            }
+        }
+        return buildPaletteTable("the built-in palette");
+    }
+
+    // each line is "R G B 'marker'", and blank lines or lines starting with // are skipped
+    char line[128];
+    int lineNumber = 0;
+    while (fgets(line, sizeof(line), paletteFile) != NULL) {
+        lineNumber++;
+
+        char* start = line;
+        while (*start == ' ' || *start == '\t') start++;
+        if (*start == '\n' || *start == '\r' || *start == '\0' || strncmp(start, "//", 2) == 0) {
+            continue;
+        }
+
+        int r, g, b;
+        char marker;
+        if (sscanf(start, "%d %d %d '%c'", &r, &g, &b, &marker) != 4 || r < 0 || r > 255 || g < 0 || g > 255 || b < 0 || b > 255) {
+            fprintf(stderr, "ERROR: %s line %d should be \"R G B 'marker'\" with each color from 0 to 255\n", fileName, lineNumber);
+            fclose(paletteFile);
+            return 0;
+        }
+
+        // a marker the game doesn't read would only make a level it refuses to load
+        if (!isGameMarker(marker)) {
+            fprintf(stderr, "ERROR: %s line %d maps a color to '%c', which isn't a marker the game knows\n", fileName, lineNumber, marker);
+            fclose(paletteFile);
+            return 0;
+        }
+
+        if (!addPaletteColor(COLOR_KEY(r, g, b), marker)) {
+            fclose(paletteFile);
+            return 0;
+        }
+    }
+    fclose(paletteFile);
+
+    return buildPaletteTable(fileName);
+}
 
-    imageToGrid(imageName, grid);
-    gridToTxt(fileName, grid);
+int isGameMarker(char marker) {
 
+    // the walls, open tiles and start positions, then every enemy and item that has a marker
+    if (marker == '#' || marker == ' ' || marker == 'X' || marker == 'E') {
+        return 1;
+    }
+    for (int i = 0; i < NUM_RECORD_TYPES; i++) {
+        if (recordMarkers[i] != 0 && marker == recordMarkers[i]) {
+            return 1;
+        }
+    }
     return 0;
 }
 
-void gridToTxt(char* fileName, char grid[GRID_SIZE][GRID_SIZE]) {
-    char filePath[100];
+int addPaletteColor(uint32_t colorKey, char marker) {
 
-    // concatenate the file name to the defined file path to prepare being opened
-    strcpy(filePath, outputDirectory);
-    strcat(filePath, fileName);
+    // grow the list of colors, doubling its size whenever it fills up
+    if (palette.count == palette.capacity) {
+        int newCapacity = palette.capacity == 0 ? 32 : palette.capacity * 2;
+        uint32_t* keys = realloc(palette.keys, newCapacity * sizeof(uint32_t));
+        if (keys != NULL) palette.keys = keys;
+        char* markers = realloc(palette.markers, newCapacity * sizeof(char));
+        if (markers != NULL) palette.markers = markers;
+
+        if (keys == NULL || markers == NULL) {
+            fprintf(stderr, "MALLOC ERROR: Memory allocation for the palette failed!\n");
+            return 0;
+        }
+        palette.capacity = newCapacity;
+    }
+
+    palette.keys[palette.count] = colorKey;
+    palette.markers[palette.count] = marker;
+    palette.count++;
+    return 1;
+}
+
+int buildPaletteTable(const char* fileName) {
+
+    // the table has at least twice as many slots as colors, so probes stay short
+    int slotCount = 16;
+    while (slotCount < palette.count * 2) {
+        slotCount *= 2;
+    }
+    palette.slotKeys = calloc(slotCount, sizeof(uint32_t));
+    palette.slotMarkers = malloc(slotCount * sizeof(char));
+    if (palette.slotKeys == NULL || palette.slotMarkers == NULL) {
+        fprintf(stderr, "MALLOC ERROR: Memory allocation for the palette table failed!\n");
+        return 0;
+    }
+    palette.slotMask = slotCount - 1;
+
+    for (int i = 0; i < palette.count; i++) {
+        uint32_t slot = hashColorKey(palette.keys[i]) & palette.slotMask;
+        while (palette.slotKeys[slot] != 0) {
+
+            // every color can only stand for one thing, otherwise which entity a pixel becomes would depend on the order of the file
+            if (palette.slotKeys[slot] == (palette.keys[i] | SLOT_USED)) {
+                fprintf(stderr, "ERROR: %s lists the color %u %u %u more than once\n", fileName,
+                    palette.keys[i] & 0xFF, (palette.keys[i] >> 8) & 0xFF, palette.keys[i] >> 16);
+                return 0;
+            }
+            slot = (slot + 1) & palette.slotMask;
+        }
+        palette.slotKeys[slot] = palette.keys[i] | SLOT_USED;
+        palette.slotMarkers[slot] = palette.markers[i];
+    }
+    return 1;
+}
+
+uint32_t hashColorKey(uint32_t colorKey) {
+    return (colorKey * 2654435761u) >> 8; // multiplying by a large odd constant spreads neighboring colors across the table
+}
+
+void freePalette(void) {
+    free(palette.keys);
+    free(palette.markers);
+    free(palette.slotKeys);
+    free(palette.slotMarkers);
+    palette = (Palette){ 0 };
+}
+
+char determineChar(uint32_t colorKey) {
+
+    // mapping each pixel's color from the image to its corresponding entity type by probing the palette table
+    uint32_t slot = hashColorKey(colorKey) & palette.slotMask;
+    while (palette.slotKeys[slot] != 0) {
+        if (palette.slotKeys[slot] == (colorKey | SLOT_USED)) {
+            return palette.slotMarkers[slot];
+        }
+        slot = (slot + 1) & palette.slotMask;
+    }
+    return '?'; // return an unknown marker if no matches were found
+}
+
+/* translates a run of RGB pixels into their grid markers. built with AVX2 and given a small palette, 16 pixels are
+    matched per pass: their RGB bytes are shuffled into 24 bit keys, and each palette color is compared against all of them
+    at once. bigger palettes, the last few pixels and builds without AVX2 go through determineChar one at a time. */
+void convertPixels(const uint8_t* rgb, int pixelCount, char* markers) {
+    int i = 0;
+
+#ifdef __AVX2__
+    // picks the 3 bytes of each of 4 pixels out of a 16 byte row of RGB values, leaving the top byte of each key 0
+    const __m256i toKeys = _mm256_setr_epi8(
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+
+    // picks the marker out of the low byte of each key's slot
+    const __m256i toMarkers = _mm256_setr_epi8(
+        0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+
+    // each 8 pixel half reads 16 bytes from its last 4 pixels, which runs 4 bytes past its own RGB values
+    for (; palette.count <= MAX_SIMD_PALETTE && (i + 16) * 3 + 4 <= pixelCount * 3; i += 16) {
+        const uint8_t* pixels = rgb + i * 3;
+        __m256i keys[2];
+        __m256i found[2];
+
+        for (int half = 0; half < 2; half++) {
+            const uint8_t* start = pixels + half * 24;
+            __m256i bytes = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)start)),
+                _mm_loadu_si128((const __m128i*)(start + 12)), 1);
+            keys[half] = _mm256_shuffle_epi8(bytes, toKeys);
+            found[half] = _mm256_set1_epi32('?');
+        }
+
+        // no color is in the palette twice, so at most one of them matches each pixel
+        for (int m = 0; m < palette.count; m++) {
+            __m256i color = _mm256_set1_epi32(palette.keys[m]);
+            __m256i marker = _mm256_set1_epi32((unsigned char)palette.markers[m]);
+            for (int half = 0; half < 2; half++) {
+                found[half] = _mm256_blendv_epi8(found[half], marker, _mm256_cmpeq_epi32(keys[half], color));
+            }
+        }
+
+        for (int half = 0; half < 2; half++) {
+            __m256i packed = _mm256_shuffle_epi8(found[half], toMarkers);
+            uint32_t low = _mm_cvtsi128_si32(_mm256_castsi256_si128(packed));
+            uint32_t high = _mm_cvtsi128_si32(_mm256_extracti128_si256(packed, 1));
+            memcpy(markers + i + half * 8, &low, 4);
+            memcpy(markers + i + half * 8 + 4, &high, 4);
+        }
+    }
+#endif
+
+    for (; i < pixelCount; i++) {
+        markers[i] = determineChar(COLOR_KEY(rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2]));
+    }
+}
+
+char* imageToGrid(const char* imageName, int* width, int* height) {
+    ImageRows* rows = openImageRows(imageName);
+    if (rows == NULL) {
+        return NULL;
+    }
+
+    // the whole board is kept, one row after another, since a record needs every type counted before it can be built
+    char* grid = malloc((size_t)rows->width * rows->height);
+    if (grid == NULL) {
+        fprintf(stderr, "MALLOC ERROR: Memory allocation for the level grid failed!\n");
+        closeImageRows(rows);
+        return NULL;
+    }
+
+    // translate each row of pixels to chars by matching their RGB values to the corresponding entity types
+    for (int y = 0; y < rows->height; y++) {
+        char* markers = grid + (size_t)y * rows->width;
+        if (!readImageRow(rows, markers)) {
+            fprintf(stderr, "ERROR: The image could not be decoded.\n");
+            free(grid);
+            closeImageRows(rows);
+            return NULL;
+        }
+
+        // handle any unknown colors in the image
+        char* unknown = memchr(markers, '?', rows->width);
+        if (unknown != NULL) {
+            fprintf(stderr, "ERROR: Unknown color located at row=%d column=%d\n", y, (int)(unknown - markers));
+            free(grid);
+            closeImageRows(rows);
+            return NULL;
+        }
+    }
+
+    *width = rows->width;
+    *height = rows->height;
+    closeImageRows(rows); // close the image when finished
+    return grid;
+}
+
+int imageToTxt(const char* imageName, const char* filePath) {
+    ImageRows* rows = openImageRows(imageName);
+    if (rows == NULL) {
+        return 0;
+    }
+
+    char* markers = malloc(rows->width + 1); // +1 for the newline ending each row
+    if (markers == NULL) {
+        fprintf(stderr, "MALLOC ERROR: Memory allocation for an image row failed!\n");
+        closeImageRows(rows);
+        return 0;
+    }
 
     // opening a new text file to write into
     FILE* newFile = fopen(filePath, "w");
     if (newFile == NULL) {
         fprintf(stderr, "ERROR: Could not export image to .txt file\n");
-        return;
+        free(markers);
+        closeImageRows(rows);
+        return 0;
+    }
+
+    // boards that aren't the default size start with a "width height" line, which the game reads to size the board
+    if (rows->width != GRID_SIZE || rows->height != GRID_SIZE) {
+        fprintf(newFile, "%d %d\n", rows->width, rows->height);
+    }
+
+    // each row is written out as soon as it's decoded, so only a couple of rows of the image are ever held in memory
+    int converted = 1;
+    for (int y = 0; y < rows->height; y++) {
+        if (!readImageRow(rows, markers)) {
+            fprintf(stderr, "ERROR: The image could not be decoded.\n");
+            converted = 0;
+            break;
+        }
+
+        // handle any unknown colors in the image
+        char* unknown = memchr(markers, '?', rows->width);
+        if (unknown != NULL) {
+            fprintf(stderr, "ERROR: Unknown color located at row=%d column=%d\n", y, (int)(unknown - markers));
+            converted = 0;
+            break;
+        }
+
+        markers[rows->width] = '\n';
+        fwrite(markers, 1, rows->width + 1, newFile);
+    }
+
+    if (fclose(newFile) != 0 && converted) {
+        fprintf(stderr, "ERROR: Could not export image to .txt file\n");
+        converted = 0;
+    }
+
+    // don't leave half a level behind
+    if (!converted) {
+        remove(filePath);
+    }
+
+    free(markers);
+    closeImageRows(rows);
+    return converted;
+}
+
+ImageRows* openImageRows(const char* imageName) {
+    ImageRows* rows = calloc(1, sizeof(ImageRows));
+    if (rows == NULL) {
+        fprintf(stderr, "MALLOC ERROR: Memory allocation for the image decoder failed!\n");
+        return NULL;
+    }
+    rows->blockType = NO_BLOCK;
+
+    rows->file = fopen(imageName, "rb");
+    if (rows->file == NULL) {
+        printf("ERROR: The image could not be loaded.\n");
+        free(rows);
+        return NULL;
     }
 
-    // copying the grid data to the text file
-    for (int i = 0; i < GRID_SIZE; i++) {
-        for (int j = 0; j < GRID_SIZE; j++) {
-            fputc(grid[i][j], newFile);
+    // the signature, then the IHDR chunk, which every PNG starts with
+    static const uint8_t signature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+    uint8_t header[29];
+    int isPng = fread(header, 1, sizeof(header), rows->file) == sizeof(header) && memcmp(header, signature, 8) == 0 &&
+        readBigEndian(header + 8) == 13 && memcmp(header + 12, "IHDR", 4) == 0;
+
+    rows->width = isPng ? (int)readBigEndian(header + 16) : 0;
+    rows->height = isPng ? (int)readBigEndian(header + 20) : 0;
+    rows->bitDepth = header[24];
+    rows->colorType = header[25];
+    int isInterlaced = header[28];
+
+    // a PNG too big to be a board is turned away before any of it is decoded
+    if (isPng && !isBoardSize(rows->width, rows->height)) {
+        fclose(rows->file);
+        free(rows);
+        return NULL;
+    }
+
+    /* 8 bit RGB and RGBA images, and palette images of any bit depth, are decoded here a row at a time as long as they
+        aren't interlaced. anything else is rare for pixel art, so it's left to stb_image, which decodes the whole image at once. */
+    int isRGB = rows->bitDepth == 8 && (rows->colorType == 2 || rows->colorType == 6);
+    int isIndexed = rows->colorType == 3 && (rows->bitDepth == 1 || rows->bitDepth == 2 || rows->bitDepth == 4 || rows->bitDepth == 8);
+    if (isPng && !isInterlaced && (isRGB || isIndexed) && findImageData(rows)) {
+
+        rows->bytesPerPixel = rows->colorType == 6 ? 4 : rows->colorType == 2 ? 3 : 1;
+        rows->rowBytes = isIndexed ? (rows->width * rows->bitDepth + 7) / 8 : rows->width * rows->bytesPerPixel;
+        rows->previousRow = calloc(rows->rowBytes, 1); // the filters treat the row above the first as all zeros
+        rows->currentRow = malloc(rows->rowBytes);
+        rows->rgbRow = rows->bytesPerPixel == 4 ? malloc(rows->width * 3) : NULL;
+        if (rows->previousRow == NULL || rows->currentRow == NULL || (rows->bytesPerPixel == 4 && rows->rgbRow == NULL)) {
+            fprintf(stderr, "MALLOC ERROR: Memory allocation for the image rows failed!\n");
+            closeImageRows(rows);
+            return NULL;
         }
-        fputc('\n', newFile);
+        return rows;
     }
 
-    fclose(newFile);
+    fclose(rows->file);
+    rows->file = NULL;
+
+    int bpp;
+    rows->wholeImage = stbi_load(imageName, &rows->width, &rows->height, &bpp, 3); // stbi_load returns RGB values for each pixel on the image
+    if (rows->wholeImage == NULL) {
+        printf("ERROR: The image could not be loaded.\n");
+        free(rows);
+        return NULL;
+    }
+    else if (!isBoardSize(rows->width, rows->height)) {
+        closeImageRows(rows);
+        return NULL;
+    }
+    return rows;
 }
 
-int matchesColor(Pixel x, Pixel y) {
-    return x.r == y.r && x.b == y.b && x.g == y.g; // see if all RGB values are the same between 2 pixels
+int isBoardSize(int width, int height) {
+    if (width < MIN_BOARD_SIZE || width > MAX_BOARD_SIZE || height < MIN_BOARD_SIZE || height > MAX_BOARD_SIZE) {
+        fprintf(stderr, "ERROR: The image is %dx%d, but the game only loads boards from %dx%d up to %dx%d\n", width, height,
+            MIN_BOARD_SIZE, MIN_BOARD_SIZE, MAX_BOARD_SIZE, MAX_BOARD_SIZE);
+        return 0;
+    }
+    return 1;
 }
 
-char determineChar(Pixel pixel) {
-    int numMarkers = sizeof(allMarkers) / sizeof(allMarkers[0]);
+int findImageData(ImageRows* rows) {
+
+    // skip the IHDR chunk's CRC, then every chunk up to the first IDAT (the CRCs aren't checked, the same as stb_image)
+    if (fseek(rows->file, 4, SEEK_CUR) != 0) {
+        return 0;
+    }
+
+    int hasPalette = 0;
+    uint8_t chunkHeader[8];
+    while (fread(chunkHeader, 1, 8, rows->file) == 8) {
+        uint32_t length = readBigEndian(chunkHeader);
+
+        // a palette image's colors are only matched to markers once, so each pixel is just a lookup by its index
+        if (memcmp(chunkHeader + 4, "PLTE", 4) == 0 && rows->colorType == 3) {
+            uint8_t palette[256 * 3];
+            if (length > sizeof(palette) || length % 3 != 0 || fread(palette, 1, length, rows->file) != length ||
+                fseek(rows->file, 4, SEEK_CUR) != 0) {
+                return 0;
+            }
+
+            // indices past the end of the palette don't have a color, so they count as unknown
+            memset(rows->paletteMarkers, '?', sizeof(rows->paletteMarkers));
+            for (uint32_t i = 0; i < length / 3; i++) {
+                rows->paletteMarkers[i] = determineChar(COLOR_KEY(palette[i * 3], palette[i * 3 + 1], palette[i * 3 + 2]));
+            }
+            hasPalette = 1;
+            continue;
+        }
+
+        if (memcmp(chunkHeader + 4, "IDAT", 4) == 0) {
+            if (rows->colorType == 3 && !hasPalette) {
+                return 0;
+            }
+            rows->chunkLeft = length;
 
-    // mapping each pixel's color from the image to its corresponding entity type
-    for (int i = 0; i < numMarkers; i++) {
-        if (matchesColor(pixel, allMarkers[i].color)) {
-            return allMarkers[i].gridMarker;
+            // the image data is a zlib stream: deflate compression, no preset dictionary, and a header check that's a multiple of 31
+            int method = getBits(rows, 8);
+            int flags = getBits(rows, 8);
+            return !rows->hasFailed && (method & 15) == 8 && (flags & 0x20) == 0 && (method << 8 | flags) % 31 == 0;
+        }
+        else if (memcmp(chunkHeader + 4, "IEND", 4) == 0 || fseek(rows->file, (long)length + 4, SEEK_CUR) != 0) {
+            return 0;
         }
     }
-    return '?'; // return an unknown marker if no matches were found
+    return 0;
 }
 
-void imageToGrid(const char* imageName, char grid[GRID_SIZE][GRID_SIZE]) {
-    int width, height, bpp;
-    uint8_t* rgbImage = stbi_load(imageName, &width, &height, &bpp, 3); // stbi_load returns RGB values for each pixel on the image
+int readImageRow(ImageRows* rows, char* markers) {
+    if (rows->row >= rows->height) {
+        return 0;
+    }
 
-    if (rgbImage == NULL) {
-        printf("ERROR: The image could not be loaded.\n");
-        return;
+    // an image stb_image decoded is already sitting in memory
+    if (rows->wholeImage != NULL) {
+        convertPixels(rows->wholeImage + (size_t)rows->row * rows->width * 3, rows->width, markers);
+        rows->row++;
+        return 1;
+    }
+
+    // every row starts with the filter that was used on it, which is undone using the row above
+    uint8_t filter;
+    if (!inflateBytes(rows, &filter, 1) || filter > 4 || !inflateBytes(rows, rows->currentRow, rows->rowBytes)) {
+        return 0;
+    }
+    unfilterRow(rows->currentRow, rows->previousRow, rows->rowBytes, rows->bytesPerPixel, filter);
+
+    // palette pixels never get expanded to RGB: each index (packed several to a byte below 8 bits, highest bits first) is looked up directly
+    if (rows->colorType == 3) {
+        if (rows->bitDepth == 8) {
+            for (int x = 0; x < rows->width; x++) {
+                markers[x] = rows->paletteMarkers[rows->currentRow[x]];
+            }
+        }
+        else {
+            int pixelsPerByte = 8 / rows->bitDepth;
+            int mask = (1 << rows->bitDepth) - 1;
+            for (int x = 0; x < rows->width; x++) {
+                int shift = 8 - rows->bitDepth * (x % pixelsPerByte + 1);
+                markers[x] = rows->paletteMarkers[(rows->currentRow[x / pixelsPerByte] >> shift) & mask];
+            }
+        }
     }
-    else if (width != GRID_SIZE || height != GRID_SIZE) {
-        printf("ERROR: Image has incorrect dimensions. width=%d, height=%d\n", width, height);
-        stbi_image_free(rgbImage);
-        return;
+    else {
+        // the alpha channel doesn't matter to the palette, so RGBA pixels are packed down to RGB first
+        const uint8_t* rgb = rows->currentRow;
+        if (rows->bytesPerPixel == 4) {
+            for (int x = 0; x < rows->width; x++) {
+                memcpy(rows->rgbRow + x * 3, rows->currentRow + x * 4, 3);
+            }
+            rgb = rows->rgbRow;
+        }
+        convertPixels(rgb, rows->width, markers);
     }
 
-    // traverse thru the image pixel by pixel
-    int rowCounter = 0;
-    for (int i = 0; i < GRID_SIZE * GRID_SIZE * 3; i += 3) {
-        
-        // translate each pixel to a char by matching the pixel's RGB values to its corresponding entity type
-        int entityChar = determineChar((Pixel) { rgbImage[i], rgbImage[i + 1], rgbImage[i + 2] });
+    // this row becomes the one above the next
+    uint8_t* temp = rows->previousRow;
+    rows->previousRow = rows->currentRow;
+    rows->currentRow = temp;
+    rows->row++;
 
-        // handle any unknown colors in the image
-        if (entityChar == '?') {
-            fprintf(stderr, "ERROR: Unknown color located at row=%d column=%d", rowCounter, (i / 3) % GRID_SIZE);
+    return 1;
+}
+
+void closeImageRows(ImageRows* rows) {
+    if (rows == NULL) return;
+
+    if (rows->file != NULL) fclose(rows->file);
+    if (rows->wholeImage != NULL) stbi_image_free(rows->wholeImage);
+    free(rows->previousRow);
+    free(rows->currentRow);
+    free(rows->rgbRow);
+    free(rows);
+}
+
+uint32_t readBigEndian(const uint8_t* bytes) {
+    return (uint32_t)bytes[0] << 24 | (uint32_t)bytes[1] << 16 | (uint32_t)bytes[2] << 8 | bytes[3];
+}
+
+void unfilterRow(uint8_t* row, const uint8_t* previous, int rowBytes, int bytesPerPixel, int filter) {
+
+    // each byte was stored as the difference from a prediction made from the pixel to its left, the one above, or both
+    for (int i = 0; i < rowBytes; i++) {
+        int left = i >= bytesPerPixel ? row[i - bytesPerPixel] : 0;
+        int above = previous[i];
+        int aboveLeft = i >= bytesPerPixel ? previous[i - bytesPerPixel] : 0;
+        int prediction = 0;
+
+        switch (filter) {
+        case 1: // sub
+            prediction = left;
+            break;
+        case 2: // up
+            prediction = above;
             break;
+        case 3: // average
+            prediction = (left + above) / 2;
+            break;
+        case 4: { // paeth: whichever neighbor is closest to left + above - aboveLeft
+            int estimate = left + above - aboveLeft;
+            int leftDistance = abs(estimate - left);
+            int aboveDistance = abs(estimate - above);
+            int aboveLeftDistance = abs(estimate - aboveLeft);
+            if (leftDistance <= aboveDistance && leftDistance <= aboveLeftDistance) prediction = left;
+            else if (aboveDistance <= aboveLeftDistance) prediction = above;
+            else prediction = aboveLeft;
+            break;
+        }
+        }
+        row[i] = (uint8_t)(row[i] + prediction);
+    }
+}
+
+int nextImageByte(ImageRows* rows) {
+    while (rows->inputPosition == rows->inputSize) {
+
+        // move on to the next IDAT chunk once this one runs out, skipping the CRC at the end of each
+        while (rows->chunkLeft == 0) {
+            uint8_t chunkHeader[8];
+            if (fseek(rows->file, 4, SEEK_CUR) != 0 || fread(chunkHeader, 1, 8, rows->file) != 8 ||
+                memcmp(chunkHeader + 4, "IDAT", 4) != 0) {
+                return -1;
+            }
+            rows->chunkLeft = readBigEndian(chunkHeader);
+        }
+
+        size_t wanted = rows->chunkLeft < sizeof(rows->input) ? rows->chunkLeft : sizeof(rows->input);
+        if (fread(rows->input, 1, wanted, rows->file) != wanted) {
+            return -1;
+        }
+        rows->inputSize = (int)wanted;
+        rows->inputPosition = 0;
+        rows->chunkLeft -= (uint32_t)wanted;
+    }
+    return rows->input[rows->inputPosition++];
+}
+
+int getBits(ImageRows* rows, int count) {
+
+    // deflate packs its values starting from the lowest bit of each byte
+    while (rows->bitCount < count) {
+        int byte = nextImageByte(rows);
+        if (byte < 0) {
+            rows->hasFailed = 1;
+            return 0;
+        }
+        rows->bitBuffer |= (uint32_t)byte << rows->bitCount;
+        rows->bitCount += 8;
+    }
+
+    int value = rows->bitBuffer & ((1u << count) - 1);
+    rows->bitBuffer >>= count;
+    rows->bitCount -= count;
+    return value;
+}
+
+/* fills out with the next count bytes of inflated image data. the inflater stops wherever the bytes run out and
+    picks up from there next time, with the last 32 KB of output kept around for the back references to copy from. */
+int inflateBytes(ImageRows* rows, uint8_t* out, int count) {
+    static const short lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const short lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const short distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static const short distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    int produced = 0;
+    while (produced < count) {
+        int byte;
+
+        if (rows->copyLeft > 0) { // finish copying an earlier run of bytes
+            byte = rows->window[(rows->windowPosition - rows->copyDistance) & (INFLATE_WINDOW_SIZE - 1)];
+            rows->copyLeft--;
+        }
+        else if (rows->blockType == NO_BLOCK) {
+            if (!startInflateBlock(rows)) {
+                return 0;
+            }
+            continue;
+        }
+        else if (rows->blockType == STORED_BLOCK) {
+            if (rows->storedLeft == 0) {
+                rows->blockType = NO_BLOCK;
+                continue;
+            }
+            byte = getBits(rows, 8);
+            rows->storedLeft--;
+        }
+        else {
+            int symbol = decodeSymbol(rows, &rows->lengthCode);
+            if (symbol < 0 || rows->hasFailed) {
+                return 0;
+            }
+
+            if (symbol < 256) { // a literal byte
+                byte = symbol;
+            }
+            else if (symbol == 256) { // the end of the block
+                rows->blockType = NO_BLOCK;
+                continue;
+            }
+            else { // a run of bytes copied from somewhere in the last 32 KB
+                symbol -= 257;
+                if (symbol >= 29) {
+                    return 0;
+                }
+                int length = lengthBase[symbol] + getBits(rows, lengthExtra[symbol]);
+
+                int distanceSymbol = decodeSymbol(rows, &rows->distanceCode);
+                if (distanceSymbol < 0 || distanceSymbol >= 30) {
+                    return 0;
+                }
+                int distance = distanceBase[distanceSymbol] + getBits(rows, distanceExtra[distanceSymbol]);
+                if (distance > rows->windowFill) {
+                    return 0;
+                }
+
+                rows->copyLeft = length;
+                rows->copyDistance = distance;
+                continue;
+            }
+        }
+
+        if (rows->hasFailed) {
+            return 0;
+        }
+
+        rows->window[rows->windowPosition++ & (INFLATE_WINDOW_SIZE - 1)] = (uint8_t)byte;
+        if (rows->windowFill < INFLATE_WINDOW_SIZE) rows->windowFill++;
+        out[produced++] = (uint8_t)byte;
+    }
+    return 1;
+}
+
+int startInflateBlock(ImageRows* rows) {
+    if (rows->isLastBlock) {
+        return 0; // the image data ended before every row was read
+    }
+
+    int header = getBits(rows, 3);
+    rows->isLastBlock = header & 1;
+    rows->blockType = header >> 1;
+
+    if (rows->blockType == STORED_BLOCK) {
+
+        // stored blocks start on a byte boundary, with their length followed by its complement
+        rows->bitBuffer >>= rows->bitCount & 7;
+        rows->bitCount -= rows->bitCount & 7;
+        int length = getBits(rows, 16);
+        int complement = getBits(rows, 16);
+        rows->storedLeft = length;
+        return !rows->hasFailed && length == (~complement & 0xFFFF);
+    }
+    else if (rows->blockType == FIXED_BLOCK) {
+        short lengths[288 + 30];
+        for (int i = 0; i < 288; i++) {
+            lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+        }
+        for (int i = 0; i < 30; i++) {
+            lengths[288 + i] = 5;
         }
+        return !rows->hasFailed && buildHuffmanCode(&rows->lengthCode, lengths, 288) && buildHuffmanCode(&rows->distanceCode, lengths + 288, 30);
+    }
+    else if (rows->blockType == DYNAMIC_BLOCK) {
+        return !rows->hasFailed && readDynamicCodes(rows);
+    }
+    return 0;
+}
+
+int readDynamicCodes(ImageRows* rows) {
+    static const short order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+    short lengths[286 + 30] = { 0 };
 
-        grid[rowCounter][(i / 3) % GRID_SIZE] = entityChar; // set the matching character onto the grid
+    int lengthCount = getBits(rows, 5) + 257;
+    int distanceCount = getBits(rows, 5) + 1;
+    int codeLengthCount = getBits(rows, 4) + 4;
+    if (lengthCount > 286 || distanceCount > 30) {
+        return 0;
+    }
 
-        // move to the next row if the end of the current row is reached
-        if ((i / 3) % GRID_SIZE == GRID_SIZE - 1) {
-            rowCounter++;
+    // the code lengths of the two real codes are themselves Huffman coded, using lengths given in a fixed order
+    for (int i = 0; i < codeLengthCount; i++) {
+        lengths[order[i]] = (short)getBits(rows, 3);
+    }
+    HuffmanCode lengthsCode;
+    if (rows->hasFailed || !buildHuffmanCode(&lengthsCode, lengths, 19)) {
+        return 0;
+    }
+
+    int index = 0;
+    while (index < lengthCount + distanceCount) {
+        int symbol = decodeSymbol(rows, &lengthsCode);
+        if (symbol < 0 || rows->hasFailed) {
+            return 0;
+        }
+
+        if (symbol < 16) {
+            lengths[index++] = (short)symbol;
+            continue;
+        }
+
+        // 16 repeats the last length 3-6 times, while 17 and 18 repeat a length of 0 3-10 or 11-138 times
+        short length = 0;
+        int repeat;
+        if (symbol == 16) {
+            if (index == 0) {
+                return 0;
+            }
+            length = lengths[index - 1];
+            repeat = 3 + getBits(rows, 2);
+        }
+        else if (symbol == 17) {
+            repeat = 3 + getBits(rows, 3);
+        }
+        else {
+            repeat = 11 + getBits(rows, 7);
+        }
+
+        if (index + repeat > lengthCount + distanceCount) {
+            return 0;
+        }
+        while (repeat-- > 0) {
+            lengths[index++] = length;
         }
     }
-    stbi_image_free(rgbImage); // close the image when finished
-}
\ No newline at end of file
+
+    // a block with no end-of-block code could never finish
+    if (rows->hasFailed || lengths[256] == 0) {
+        return 0;
+    }
+    return buildHuffmanCode(&rows->lengthCode, lengths, lengthCount) &&
+        buildHuffmanCode(&rows->distanceCode, lengths + lengthCount, distanceCount);
+}
+
+int buildHuffmanCode(HuffmanCode* code, const short* lengths, int symbolCount) {
+    short offsets[16];
+
+    for (int i = 0; i < 16; i++) {
+        code->counts[i] = 0;
+    }
+    for (int i = 0; i < symbolCount; i++) {
+        code->counts[lengths[i]]++;
+    }
+
+    // a set of lengths with more codes than fit in their bits can't be decoded
+    int left = 1;
+    for (int i = 1; i < 16; i++) {
+        left = left * 2 - code->counts[i];
+        if (left < 0) {
+            return 0;
+        }
+    }
+
+    // sort the symbols by code length, keeping symbol order within each length, which is the order canonical codes are assigned in
+    offsets[1] = 0;
+    for (int i = 1; i < 15; i++) {
+        offsets[i + 1] = offsets[i] + code->counts[i];
+    }
+    for (int i = 0; i < symbolCount; i++) {
+        if (lengths[i] != 0) {
+            code->symbols[offsets[lengths[i]]++] = (short)i;
+        }
+    }
+    return 1;
+}
+
+int decodeSymbol(ImageRows* rows, const HuffmanCode* code) {
+
+    // read one bit at a time until the code read so far falls within the codes of its length
+    int bits = 0, first = 0, index = 0;
+    for (int length = 1; length < 16; length++) {
+        bits |= getBits(rows, 1);
+        int count = code->counts[length];
+        if (bits - first < count) {
+            return code->symbols[index + bits - first];
+        }
+        index += count;
+        first = (first + count) << 1;
+        bits <<= 1;
+    }
+    return -1;
+}